@@ -0,0 +1,335 @@
+// Database micro-benchmarks, on a temporary file database in WAL mode.
+//
+//   bench_database [statements] [readers] [burst]
+//
+// statements: per-call latency of the hot statements with a prepare/finalize per call (how Database
+//             ran them before the statement cache) against a cached statement, plus the Database calls.
+// readers:    read throughput of 1, 2, 4 and 8 threads each serving /stats-style requests (GetUserStats,
+//             GetPendingPenanceDetailed, GetRecentGames), with no read pool (every read on the writer
+//             connection) and with a pool of 4 read connections. Only meaningful on a multi-core host.
+// burst:      1000 new matches for one link (LogGame + AddToQueue + UpdateLastMatch each) written with
+//             autocommit, one Transaction per match, and one Transaction for the whole burst.
+#include "server/database/Database.h"
+#include "server/database/HotQueries.h"
+#include "server/database/StatementCache.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Server::DB;
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    const int USERS = 200;
+    const int GAMES_PER_USER = 100;
+
+    // A database file that is deleted (with its WAL) when the benchmark is done with it
+    class TempDatabase
+    {
+    public:
+        explicit TempDatabase(const std::string &name)
+            : m_path((std::filesystem::temp_directory_path() / ("log_bench_" + name + ".db")).string())
+        {
+            Remove();
+        }
+        ~TempDatabase() { Remove(); }
+        const std::string &Path() const { return m_path; }
+
+    private:
+        void Remove()
+        {
+            for (const char *suffix : {"", "-wal", "-shm"})
+                std::filesystem::remove(m_path + suffix);
+        }
+        std::string m_path;
+    };
+
+    int64_t DiscordId(int user) { return 100000 + user; }
+    std::string MatchId(int user, int game) { return "NA1_" + std::to_string(user) + "_" + std::to_string(game); }
+
+    void LogMatch(Database &db, int user, int game)
+    {
+        int deaths = game % 9;
+        db.LogGame(DiscordId(user), MatchId(user, game), 1700000000000LL + game * 2400000LL, 1800, "Ahri", 5, deaths, 7, 50.0,
+                   180, 6.0);
+        if (deaths > 0)
+            db.AddToQueue(DiscordId(user), MatchId(user, game), "Pushups", deaths * 10, deaths);
+    }
+
+    // USERS linked accounts with GAMES_PER_USER games each, a penance for every game with deaths
+    void Seed(Database &db)
+    {
+        Database::Transaction tx(db);
+        for (int u = 0; u < USERS; ++u)
+        {
+            User user;
+            user.discord_id = DiscordId(u);
+            user.riot_puuid = "puuid-" + std::to_string(u);
+            user.riot_name = "Player" + std::to_string(u);
+            user.riot_tag = "NA1";
+            user.region = "na1";
+            db.AddUser(user);
+            for (int g = 0; g < GAMES_PER_USER; ++g)
+                LogMatch(db, u, g);
+        }
+        tx.Commit();
+    }
+
+    // Average microseconds per call of `fn` over `iterations` calls
+    double MicrosPerCall(int iterations, const std::function<void(int)> &fn)
+    {
+        for (int i = 0; i < std::min(iterations, 100); ++i)
+            fn(i); // Warm-up
+        auto start = Clock::now();
+        for (int i = 0; i < iterations; ++i)
+            fn(i);
+        return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / iterations;
+    }
+
+    // -------------------------------------------------------------------------
+    // STATEMENT CACHE
+    // -------------------------------------------------------------------------
+    // Runs `sql` once with `bind` applied, on either a fresh statement or one from `cache`
+    void RunStatement(sqlite3 *conn, StatementCache *cache, const std::string &sql, const std::function<void(sqlite3_stmt *)> &bind)
+    {
+        if (cache)
+        {
+            auto handle = cache->Acquire(sql);
+            bind(handle.get());
+            while (sqlite3_step(handle.get()) == SQLITE_ROW)
+            {
+            }
+            return;
+        }
+        sqlite3_stmt *stmt = nullptr;
+        sqlite3_prepare_v2(conn, sql.c_str(), -1, &stmt, nullptr);
+        bind(stmt);
+        while (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    void RunStatements()
+    {
+        TempDatabase file("statements");
+        {
+            Database db(file.Path(), 0);
+            Seed(db);
+        }
+
+        sqlite3 *conn = nullptr;
+        sqlite3_open(file.Path().c_str(), &conn);
+        StatementCache cache(conn);
+        const int ITERATIONS = 20000;
+
+        struct Case
+        {
+            const char *name;
+            std::string sql;
+            std::function<void(sqlite3_stmt *, int)> bind;
+        };
+        std::vector<Case> cases = {
+            {"IsMatchProcessed", HotSql::IS_MATCH_PROCESSED,
+             [](sqlite3_stmt *stmt, int i)
+             {
+                 std::string match = MatchId(i % USERS, i % GAMES_PER_USER);
+                 sqlite3_bind_text(stmt, 1, match.c_str(), -1, SQLITE_TRANSIENT);
+                 sqlite3_bind_int64(stmt, 2, DiscordId(i % USERS));
+             }},
+            {"GetUserMultiplier", HotSql::UserMultiplier("wimp_mult_lower"),
+             [](sqlite3_stmt *stmt, int i) { sqlite3_bind_int64(stmt, 1, DiscordId(i % USERS)); }},
+            {"LogGame (insert)", HotSql::LOG_GAME,
+             [](sqlite3_stmt *stmt, int i)
+             {
+                 std::string match = "NEW_" + std::to_string(i);
+                 sqlite3_bind_text(stmt, 1, match.c_str(), -1, SQLITE_TRANSIENT);
+                 sqlite3_bind_int64(stmt, 2, DiscordId(i % USERS));
+                 sqlite3_bind_int64(stmt, 3, 1800000000000LL + i);
+                 sqlite3_bind_text(stmt, 4, "Ahri", -1, SQLITE_STATIC);
+                 for (int col = 5; col <= 7; ++col)
+                     sqlite3_bind_int(stmt, col, 4);
+                 sqlite3_bind_double(stmt, 8, 50.0);
+                 sqlite3_bind_int(stmt, 9, 180);
+                 sqlite3_bind_double(stmt, 10, 6.0);
+                 sqlite3_bind_int(stmt, 11, 1800);
+             }},
+        };
+
+        std::cout << "\nPer-call latency, " << USERS << " users x " << GAMES_PER_USER << " games (us)\n"
+                  << "  statement           prepare/call      cached" << std::endl;
+        for (auto &c : cases)
+        {
+            // Inserts run inside a transaction that is rolled back, so only the statement is measured, not commits
+            sqlite3_exec(conn, "BEGIN", nullptr, nullptr, nullptr);
+            double uncached = MicrosPerCall(ITERATIONS, [&](int i) { RunStatement(conn, nullptr, c.sql, [&](sqlite3_stmt *s) { c.bind(s, i); }); });
+            sqlite3_exec(conn, "ROLLBACK", nullptr, nullptr, nullptr);
+            sqlite3_exec(conn, "BEGIN", nullptr, nullptr, nullptr);
+            double cached = MicrosPerCall(ITERATIONS, [&](int i) { RunStatement(conn, &cache, c.sql, [&](sqlite3_stmt *s) { c.bind(s, i); }); });
+            sqlite3_exec(conn, "ROLLBACK", nullptr, nullptr, nullptr);
+
+            std::cout << "  " << std::left << std::setw(18) << c.name << std::right << std::fixed << std::setprecision(2)
+                      << std::setw(14) << uncached << std::setw(12) << cached << std::endl;
+        }
+        cache.Clear();
+        sqlite3_close(conn);
+
+        // The same operations through Database, as the tracker calls them (LogGame includes its commit
+        // and the stats summary update)
+        Database db(file.Path(), 4);
+        double processed = MicrosPerCall(ITERATIONS, [&](int i) { db.IsMatchProcessed(DiscordId(i % USERS), MatchId(i % USERS, i % GAMES_PER_USER)); });
+        double multiplier = MicrosPerCall(ITERATIONS, [&](int i) { db.GetUserMultiplier(DiscordId(i % USERS), "lower"); });
+        double logGame = MicrosPerCall(2000, [&](int i) { LogMatch(db, i % USERS, GAMES_PER_USER + i); });
+        std::cout << std::fixed << std::setprecision(2) << "  Database::IsMatchProcessed   " << processed << "\n"
+                  << "  Database::GetUserMultiplier  " << multiplier << "\n"
+                  << "  Database::LogGame+AddToQueue " << logGame << std::endl;
+    }
+
+    // -------------------------------------------------------------------------
+    // READ POOL
+    // -------------------------------------------------------------------------
+    // Requests per second served by `workers` threads over a fixed time window
+    double RunReaders(const std::string &path, size_t pool, int workers)
+    {
+        Database db(path, pool);
+        const auto WINDOW = std::chrono::seconds(2);
+        std::atomic<bool> stop{false};
+        std::atomic<uint64_t> requests{0};
+
+        std::vector<std::thread> threads;
+        for (int w = 0; w < workers; ++w)
+        {
+            threads.emplace_back(
+                [&, w]
+                {
+                    uint64_t served = 0;
+                    for (int i = w; !stop.load(std::memory_order_relaxed); i += workers)
+                    {
+                        int64_t user = DiscordId(i % USERS);
+                        db.GetUserStats(user);
+                        db.GetPendingPenanceDetailed(user);
+                        db.GetRecentGames(user, 10);
+                        ++served;
+                    }
+                    requests += served;
+                });
+        }
+        auto start = Clock::now();
+        std::this_thread::sleep_for(WINDOW);
+        stop = true;
+        for (auto &t : threads)
+            t.join();
+        return requests / std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    void RunReadPool()
+    {
+        TempDatabase file("readers");
+        {
+            Database db(file.Path(), 0);
+            Seed(db);
+        }
+
+        std::cout << "\nRead throughput, GetUserStats + GetPendingPenanceDetailed + GetRecentGames (requests/s)\n"
+                  << " workers      pool 0      pool 4" << std::endl;
+        for (int workers : {1, 2, 4, 8})
+        {
+            double serial = RunReaders(file.Path(), 0, workers);
+            double pooled = RunReaders(file.Path(), 4, workers);
+            std::cout << std::fixed << std::setprecision(0) << std::setw(8) << workers << std::setw(12) << serial
+                      << std::setw(12) << pooled << std::endl;
+        }
+    }
+
+    // -------------------------------------------------------------------------
+    // WRITE BURST
+    // -------------------------------------------------------------------------
+    enum class Batching
+    {
+        None,     // Every call commits on its own
+        PerMatch, // The tracker's pipeline engine: one commit per persisted match
+        PerBurst  // The task engine: one commit per poll
+    };
+
+    double RunBurst(Batching batching)
+    {
+        const int MATCHES = 1000;
+        TempDatabase file("burst");
+        Database db(file.Path(), 0);
+        Seed(db);
+
+        auto record = [&](int game)
+        {
+            LogMatch(db, 0, GAMES_PER_USER + game);
+            db.UpdateLastMatch(DiscordId(0), "puuid-0", MatchId(0, GAMES_PER_USER + game), 1800000000 + game);
+        };
+
+        auto start = Clock::now();
+        if (batching == Batching::PerBurst)
+        {
+            Database::Transaction tx(db);
+            for (int g = 0; g < MATCHES; ++g)
+                record(g);
+            tx.Commit();
+        }
+        else
+        {
+            for (int g = 0; g < MATCHES; ++g)
+            {
+                if (batching == Batching::PerMatch)
+                {
+                    Database::Transaction tx(db);
+                    record(g);
+                    tx.Commit();
+                }
+                else
+                    record(g);
+            }
+        }
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void RunWriteBurst()
+    {
+        std::cout << "\nWrite burst, 1000 new matches for one link (ms)\n"
+                  << "  autocommit  per match  per burst" << std::endl;
+        double none = RunBurst(Batching::None);
+        double perMatch = RunBurst(Batching::PerMatch);
+        double perBurst = RunBurst(Batching::PerBurst);
+        std::cout << std::fixed << std::setprecision(1) << std::setw(12) << none << std::setw(11) << perMatch
+                  << std::setw(11) << perBurst << std::endl;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::vector<std::string> modes(argv + 1, argv + argc);
+    if (modes.empty())
+        modes = {"statements", "readers", "burst"};
+
+    std::cout << "hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+
+    for (const auto &mode : modes)
+    {
+        if (mode == "statements")
+            RunStatements();
+        else if (mode == "readers")
+            RunReadPool();
+        else if (mode == "burst")
+            RunWriteBurst();
+        else
+        {
+            std::cerr << "Unknown benchmark '" << mode << "'" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,218 @@
+// Match payload parsing: the SAX summary (ParseMatchSummary) against the DOM path AnalyzeMatch used before it.
+//
+//   bench_match_parser [fixture.json...]
+//
+// Without arguments every *.json in bench/fixtures is used. A fixture is a raw
+// /lol/match/v5/matches/{id} response body; save one with
+//   curl -H "X-Riot-Token: $RIOT_API_KEY" https://americas.api.riotgames.com/lol/match/v5/matches/NA1_... > fixture.json
+// match_v5_ranked_solo.json has every field of a dataVersion 2 payload (all participant stats,
+// challenges, perks, missions, teams) with generated values; add real captures next to it.
+// For each fixture it first checks that both paths give the same MatchStats for all ten players
+// (exits with 1 if not), then reports time, heap allocations and bytes allocated per parse.
+#include "server/riot/MatchParser.h"
+#include "server/riot/RiotClient.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef BENCH_FIXTURE_DIR
+#define BENCH_FIXTURE_DIR "server/bench/fixtures"
+#endif
+
+// Every heap allocation in the process is counted, so a run's difference is what one parse costs
+namespace
+{
+    std::atomic<uint64_t> g_allocs{0};
+    std::atomic<uint64_t> g_allocBytes{0};
+} // namespace
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete" // malloc/free behind a replaced new/delete is fine
+#endif
+
+void *operator new(std::size_t size)
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_allocBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+using Server::Riot::MatchStats;
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    // What AnalyzeMatch did before the SAX parser: a full DOM, then copies of info and participants
+    MatchStats AnalyzeWithDom(const std::string &body, const std::string &puuid)
+    {
+        MatchStats stats;
+        auto json = nlohmann::json::parse(body);
+        if (json.is_null() || !json.contains("info"))
+            return stats;
+
+        auto info = json["info"];
+        auto participants = info["participants"];
+        long gameDuration = info.value("gameDuration", 0L);
+
+        nlohmann::json userP;
+        int teamId = 0;
+        bool found = false;
+        int teamKills = 0;
+        for (const auto &p : participants)
+        {
+            if (p.value("puuid", "") == puuid)
+            {
+                userP = p;
+                teamId = p.value("teamId", 0);
+                found = true;
+            }
+        }
+        if (!found)
+            return stats;
+
+        for (const auto &p : participants)
+        {
+            if (p.value("teamId", 0) == teamId)
+                teamKills += p.value("kills", 0);
+        }
+
+        stats.valid = true;
+        stats.champion_name = userP.value("championName", "Unknown");
+        stats.kills = userP.value("kills", 0);
+        stats.deaths = userP.value("deaths", 0);
+        stats.assists = userP.value("assists", 0);
+        stats.win = userP.value("win", false);
+        stats.timestamp = info.value("gameCreation", 0LL);
+        stats.gameDuration = gameDuration;
+
+        int involvement = stats.kills + stats.assists;
+        stats.kp_percent = (teamKills > 0) ? ((double)involvement / teamKills * 100.0) : 0.0;
+        stats.cs = userP.value("totalMinionsKilled", 0) + userP.value("neutralMinionsKilled", 0);
+        stats.cs_min = (gameDuration > 0) ? (stats.cs / (gameDuration / 60.0)) : 0.0;
+        return stats;
+    }
+
+    MatchStats AnalyzeWithSax(const std::string &match_id, const std::string &body, const std::string &puuid)
+    {
+        auto summary = Server::Riot::ParseMatchSummary(match_id, body);
+        return summary ? Server::Riot::RiotClient::StatsFor(*summary, puuid) : MatchStats{};
+    }
+
+    bool SameStats(const MatchStats &a, const MatchStats &b)
+    {
+        return a.valid == b.valid && a.champion_name == b.champion_name && a.kills == b.kills && a.deaths == b.deaths &&
+               a.assists == b.assists && a.win == b.win && a.timestamp == b.timestamp && a.gameDuration == b.gameDuration &&
+               a.cs == b.cs && std::abs(a.kp_percent - b.kp_percent) < 1e-9 && std::abs(a.cs_min - b.cs_min) < 1e-9;
+    }
+
+    struct Result
+    {
+        double micros = 0.0;
+        double allocs = 0.0;
+        double kib = 0.0;
+    };
+
+    // Average cost of one call of `parse`
+    template <typename Fn> Result Measure(int iterations, Fn &&parse)
+    {
+        parse(); // Warm-up
+        uint64_t allocs = g_allocs.load();
+        uint64_t bytes = g_allocBytes.load();
+        auto start = Clock::now();
+        for (int i = 0; i < iterations; ++i)
+            parse();
+        double micros = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+        Result result;
+        result.micros = micros / iterations;
+        result.allocs = double(g_allocs.load() - allocs) / iterations;
+        result.kib = double(g_allocBytes.load() - bytes) / iterations / 1024.0;
+        return result;
+    }
+
+    void Print(const char *name, const Result &r)
+    {
+        std::cout << "  " << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << r.micros << " us" << std::setw(10) << r.allocs << " allocs" << std::setw(10) << r.kib
+                  << " KiB" << std::endl;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::vector<std::filesystem::path> fixtures;
+    for (int i = 1; i < argc; ++i)
+        fixtures.emplace_back(argv[i]);
+    if (fixtures.empty())
+    {
+        for (const auto &entry : std::filesystem::directory_iterator(BENCH_FIXTURE_DIR))
+        {
+            if (entry.path().extension() == ".json")
+                fixtures.push_back(entry.path());
+        }
+        std::sort(fixtures.begin(), fixtures.end());
+    }
+    if (fixtures.empty())
+    {
+        std::cerr << "No fixtures found in " << BENCH_FIXTURE_DIR << std::endl;
+        return 1;
+    }
+
+    bool mismatch = false;
+    for (const auto &path : fixtures)
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        const std::string body = buffer.str();
+        const std::string match_id = path.stem().string();
+
+        // Every player in the match, as the tracker asks for them
+        std::vector<std::string> puuids;
+        auto summary = Server::Riot::ParseMatchSummary(match_id, body);
+        if (!summary)
+        {
+            std::cerr << path << ": not a match-v5 payload" << std::endl;
+            return 1;
+        }
+        for (const auto &p : summary->participants)
+            puuids.push_back(p.puuid);
+
+        bool same = true;
+        for (const auto &puuid : puuids)
+        {
+            if (!SameStats(AnalyzeWithDom(body, puuid), AnalyzeWithSax(match_id, body, puuid)))
+            {
+                std::cerr << path << ": SAX and DOM stats differ for " << puuid << std::endl;
+                same = false;
+            }
+        }
+        mismatch |= !same;
+
+        const int ITERATIONS = 200;
+        size_t next = 0;
+        auto dom = Measure(ITERATIONS, [&] { return AnalyzeWithDom(body, puuids[next++ % puuids.size()]); });
+        auto sax = Measure(ITERATIONS, [&] { return AnalyzeWithSax(match_id, body, puuids[next++ % puuids.size()]); });
+
+        std::cout << path.filename().string() << " (" << body.size() / 1024 << " KiB, " << puuids.size()
+                  << " participants, fields match: " << (same ? "yes" : "NO") << ")" << std::endl;
+        Print("DOM + copies", dom);
+        Print("SAX summary", sax);
+    }
+    return mismatch ? 1 : 0;
+}
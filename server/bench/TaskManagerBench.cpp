@@ -0,0 +1,193 @@
+// TaskManager micro-benchmarks.
+//
+//   bench_task_manager [latency] [throughput] [threads...]
+//
+// latency:    idle-to-dispatch time. A High task is submitted to a pool whose workers are all asleep,
+//             and the time until a worker starts running it is recorded.
+// throughput: tracker-style fan-out. A Low task submitted from outside the pool spawns 25k tiny Low
+//             tasks from its worker, as TaskTrackerUpdate does with its user checks. Runs each
+//             scheduler mode and reports tasks per second over 8 sweeps.
+#include "server/core/TaskManager.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Core::Utils;
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    class BenchTask : public Task
+    {
+    public:
+        std::function<void()> fn;
+        void process() override { fn(); }
+    };
+
+    std::unique_ptr<Task> MakeTask(TaskPriority priority, std::function<void()> fn)
+    {
+        auto task = std::make_unique<BenchTask>();
+        task->priority = priority;
+        task->fn = std::move(fn);
+        return task;
+    }
+
+    TaskManagerOptions Options(size_t threads, SchedulerMode scheduler)
+    {
+        TaskManagerOptions options;
+        options.num_threads = threads;
+        options.scheduler = scheduler;
+        options.stats_interval = std::chrono::seconds(0);
+        options.capacity = {0, 0, 0};
+        return options;
+    }
+
+    // Silences the pool's own logging (queue high-water marks) while a run is being measured
+    class QuietLogs
+    {
+    public:
+        QuietLogs() : m_saved(std::cout.rdbuf(&m_null)) {}
+        ~QuietLogs() { std::cout.rdbuf(m_saved); }
+
+    private:
+        struct NullBuffer : std::streambuf
+        {
+            int overflow(int c) override { return c; }
+        } m_null;
+        std::streambuf *m_saved;
+    };
+
+    double Percentile(std::vector<double> sorted, double p)
+    {
+        if (sorted.empty())
+            return 0.0;
+        std::sort(sorted.begin(), sorted.end());
+        size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()));
+        return sorted[index];
+    }
+
+    // -------------------------------------------------------------------------
+    // IDLE-TO-DISPATCH LATENCY
+    // -------------------------------------------------------------------------
+    void RunLatency(size_t threads)
+    {
+        const int SAMPLES = 200;
+        std::vector<double> micros;
+        {
+            QuietLogs quiet;
+            auto ctx = std::make_shared<AppContext>();
+            TaskManager pool(Options(threads, SchedulerMode::Shared), ctx);
+
+            for (int i = 0; i < SAMPLES; ++i)
+            {
+                // Let every worker go back to sleep before the next submit
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+                std::promise<Clock::time_point> started;
+                auto future = started.get_future();
+                auto submitted = Clock::now();
+                pool.submit(MakeTask(TaskPriority::High, [&started] { started.set_value(Clock::now()); }));
+                micros.push_back(std::chrono::duration<double, std::micro>(future.get() - submitted).count());
+            }
+        }
+
+        std::cout << std::fixed << std::setprecision(1) << std::setw(8) << threads << std::setw(12)
+                  << Percentile(micros, 0.50) << std::setw(12) << Percentile(micros, 0.99) << std::setw(12)
+                  << Percentile(micros, 1.0) << std::endl;
+    }
+
+    // -------------------------------------------------------------------------
+    // FAN-OUT THROUGHPUT
+    // -------------------------------------------------------------------------
+    double RunThroughput(size_t threads, SchedulerMode scheduler)
+    {
+        const int SWEEPS = 8;
+        const int FAN_OUT = 25000;
+        QuietLogs quiet;
+        auto ctx = std::make_shared<AppContext>();
+        TaskManager pool(Options(threads, scheduler), ctx);
+
+        // A little work per task, so the run measures scheduling rather than an empty loop
+        std::atomic<uint64_t> sink{0};
+        auto start = Clock::now();
+        for (int sweep = 0; sweep < SWEEPS; ++sweep)
+        {
+            std::atomic<int> remaining{FAN_OUT};
+            std::promise<void> done;
+            pool.submit(MakeTask(TaskPriority::Low,
+                                 [&]
+                                 {
+                                     for (int i = 0; i < FAN_OUT; ++i)
+                                     {
+                                         ctx->submitTask(MakeTask(TaskPriority::Low,
+                                                                  [&, i]
+                                                                  {
+                                                                      uint64_t x = i;
+                                                                      for (int k = 0; k < 64; ++k)
+                                                                          x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+                                                                      sink += x;
+                                                                      if (--remaining == 0)
+                                                                          done.set_value();
+                                                                  }));
+                                     }
+                                 }));
+            done.get_future().wait();
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return SWEEPS * FAN_OUT / seconds;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::vector<std::string> modes;
+    std::vector<size_t> threads;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (!arg.empty() && std::isdigit(static_cast<unsigned char>(arg[0])))
+            threads.push_back(std::strtoul(arg.c_str(), nullptr, 10));
+        else
+            modes.push_back(arg);
+    }
+    if (modes.empty())
+        modes = {"latency", "throughput"};
+
+    std::cout << "hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+    for (const auto &mode : modes)
+    {
+        if (mode == "latency")
+        {
+            std::cout << "\nIdle-to-dispatch latency, High task into an idle pool (us)\n"
+                      << " threads         p50         p99         max" << std::endl;
+            for (size_t n : threads.empty() ? std::vector<size_t>{1, 4} : threads)
+                RunLatency(n);
+        }
+        else if (mode == "throughput")
+        {
+            std::cout << "\nFan-out throughput, 8 sweeps x 25k Low tasks (M tasks/s)\n"
+                      << " threads      shared  work_stealing" << std::endl;
+            for (size_t n : threads.empty() ? std::vector<size_t>{4, 16, 64} : threads)
+            {
+                double shared = RunThroughput(n, SchedulerMode::Shared);
+                double stealing = RunThroughput(n, SchedulerMode::WorkStealing);
+                std::cout << std::fixed << std::setprecision(2) << std::setw(8) << n << std::setw(12) << shared / 1e6
+                          << std::setw(15) << stealing / 1e6 << std::endl;
+            }
+        }
+        else
+        {
+            std::cerr << "Unknown benchmark '" << mode << "'" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "server/core/AppContext.h"
+#include "server/discord/ComponentResponse.h"
 #include <dpp/dpp.h>
 #include <memory>
 #include <string>
@@ -27,11 +28,18 @@ namespace Core::Commands
         // The logic to run when the command is triggered
         virtual void Execute(const dpp::interaction_create_t &event, std::shared_ptr<Core::Utils::AppContext> ctx) = 0;
 
-        // Handle button clicks related to this command
-        virtual void OnButton(const dpp::button_click_t &event, std::shared_ptr<Core::Utils::AppContext> ctx) {}
+        // Handle button clicks related to this command. Answer through `response`: it may already have
+        // been acknowledged for us if the click waited too long for a worker.
+        virtual void OnButton(const dpp::button_click_t &event, std::shared_ptr<Core::Utils::AppContext> ctx,
+                              Core::Discord::ComponentResponse &response)
+        {
+        }
 
-        // Handle select menu interactions
-        virtual void OnSelect(const dpp::select_click_t &event, std::shared_ptr<Core::Utils::AppContext> ctx) {}
+        // Handle select menu interactions (answered through `response`, as for buttons)
+        virtual void OnSelect(const dpp::select_click_t &event, std::shared_ptr<Core::Utils::AppContext> ctx,
+                              Core::Discord::ComponentResponse &response)
+        {
+        }
     };
 
     // Registry to manage commands
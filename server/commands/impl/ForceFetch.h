@@ -39,11 +39,21 @@ namespace Core::Commands::Impl
                 m_cooldowns[guild_id] = now;
             } // Mutex is released here
 
-            auto task = std::make_unique<Core::Utils::TaskTrackerUpdate>();
-            task->ctx = ctx;
-            task->priority = Core::Utils::TaskPriority::High;
+            std::unique_ptr<Core::Utils::Task> task;
+            {
+                auto sweep = std::make_unique<Core::Utils::TaskTrackerUpdate>();
+                sweep->ctx = ctx;
+                sweep->priority = Core::Utils::TaskPriority::High;
+                // Merges into a sweep that is still draining and bumps its queued checks ahead of routine work
+                sweep->checkPriority = Core::Utils::TaskPriority::Standard;
+                task = std::move(sweep);
+            }
 
-            ctx->submitTask(std::move(task));
+            if (!ctx->trySubmitTask(task))
+            {
+                event.edit_original_response(dpp::message("⏳ The bot is overloaded right now, please try again in a moment."));
+                return;
+            }
 
             event.edit_original_response(dpp::message("🚀 Update queued!"));
         }
@@ -1,5 +1,6 @@
 #pragma once
 #include "server/commands/CommandSystem.h"
+#include <algorithm>
 #include <iomanip>
 #include <sstream>
 
@@ -8,6 +9,8 @@ namespace Core::Commands::Impl
     class CmdLeaderboard : public ICommand
     {
     public:
+        static constexpr size_t PAGE_SIZE = 10;
+
         std::string GetName() const override { return "leaderboard"; }
         std::string GetDescription() const override { return "Show top users by category"; }
 
@@ -18,6 +21,15 @@ namespace Core::Commands::Impl
             typeOpt.add_choice(dpp::command_option_choice("Total Deaths", "deaths"));
             typeOpt.add_choice(dpp::command_option_choice("Average KDA", "kda"));
             command.add_option(typeOpt);
+
+            dpp::command_option scopeOpt(dpp::co_string, "scope", "Whose ranking (default: everyone)", false);
+            scopeOpt.add_choice(dpp::command_option_choice("Everyone", "global"));
+            scopeOpt.add_choice(dpp::command_option_choice("This Server", "server"));
+            command.add_option(scopeOpt);
+
+            dpp::command_option pageOpt(dpp::co_integer, "page", "Page number (default: 1)", false);
+            pageOpt.set_min_value(1);
+            command.add_option(pageOpt);
         }
 
         void Execute(const dpp::interaction_create_t &event, std::shared_ptr<Core::Utils::AppContext> ctx) override
@@ -26,7 +38,18 @@ namespace Core::Commands::Impl
             if (event.get_parameter("category").index() != 0) // if exists
                 type = std::get<std::string>(event.get_parameter("category"));
 
-            auto weights = ctx->db->GetLeaderboard(type);
+            // Global unless asked for this server: a server board only lists users who have run a command
+            // there since membership started being recorded, so it starts out empty. Outside a server (DMs)
+            // there is only the global board.
+            int64_t guildId = 0;
+            if (event.get_parameter("scope").index() != 0 && std::get<std::string>(event.get_parameter("scope")) == "server")
+                guildId = event.command.guild_id;
+
+            int64_t pageNumber = 1;
+            if (event.get_parameter("page").index() != 0)
+                pageNumber = std::max<int64_t>(1, std::get<int64_t>(event.get_parameter("page")));
+
+            auto board = ctx->db->GetLeaderboard(type, guildId, static_cast<size_t>(pageNumber - 1) * PAGE_SIZE, PAGE_SIZE);
 
             std::string title = "🏆 Leaderboard: ";
             std::string fieldName = "Score";
@@ -38,38 +61,39 @@ namespace Core::Commands::Impl
                                    .set_title(title)
                                    .set_color(0xFFD700); // Gold
 
-            if (weights.empty())
+            if (board.entries.empty())
             {
-                embed.set_description("No data recorded yet.");
+                embed.set_description(board.total == 0 ? "No data recorded yet." : "No entries on this page.");
             }
             else
             {
                 std::stringstream ss;
-                int rank = 1;
-                for (const auto &p : weights)
+                for (const auto &entry : board.entries)
                 {
                     std::string medal = "";
-                    if (rank == 1) medal = "🥇";
-                    else if (rank == 2) medal = "🥈";
-                    else if (rank == 3) medal = "🥉";
-                    else medal = "#" + std::to_string(rank);
+                    if (entry.rank == 1) medal = "🥇";
+                    else if (entry.rank == 2) medal = "🥈";
+                    else if (entry.rank == 3) medal = "🥉";
+                    else medal = "#" + std::to_string(entry.rank);
 
                     if (type == "kda")
                     {
-                        double kda = (double)p.second / 100.0;
                          std::stringstream kdaSS;
-                         kdaSS << std::fixed << std::setprecision(2) << kda;
-                         ss << "**" << medal << "** " << p.first << " — **" << kdaSS.str() << "**\n";
+                         kdaSS << std::fixed << std::setprecision(2) << entry.value;
+                         ss << "**" << medal << "** " << entry.name << " — **" << kdaSS.str() << "**\n";
                     }
                     else
                     {
-                        ss << "**" << medal << "** " << p.first << " — **" << p.second << "**\n";
+                        ss << "**" << medal << "** " << entry.name << " — **" << static_cast<int64_t>(entry.value) << "**\n";
                     }
-                    rank++;
                 }
                 embed.set_description(ss.str());
             }
 
+            size_t pages = std::max<size_t>(1, (board.total + PAGE_SIZE - 1) / PAGE_SIZE);
+            embed.set_footer(std::string(guildId != 0 ? "This server" : "Everyone") + " · Page " + std::to_string(pageNumber) + " of " +
+                                 std::to_string(pages), "");
+
             event.edit_original_response(dpp::message(embed));
         }
     };
@@ -1,5 +1,6 @@
 #pragma once
 #include "server/commands/CommandSystem.h"
+#include "server/core/TaskManager.h"
 
 namespace Core::Commands::Impl
 {
@@ -34,26 +35,43 @@ namespace Core::Commands::Impl
             std::string region = std::get<std::string>(event.get_parameter("region"));
             auto user = event.command.get_issuing_user();
 
-            auto account = ctx->riot->GetAccount(name, tag, region);
-            if (!std::get<0>(account).empty())
+            // Resolve the Riot ID without holding this worker. The DB reads and the AddUser write then
+            // continue on a worker, not on the HTTP thread that delivers Riot's answer.
+            LinkAccount(event, ctx, name, tag, region, user.id).Start(ctx, Core::Utils::TaskPriority::High);
+        }
+
+    private:
+        static Core::Utils::CoTask LinkAccount(dpp::interaction_create_t event, std::shared_ptr<Core::Utils::AppContext> ctx,
+                                               std::string name, std::string tag, std::string region, int64_t discordId)
+        {
+            // Detached from TaskSlashCommand, so its catch can't answer the deferred reply for us
+            try
             {
+                auto account = co_await Core::Utils::Async<std::tuple<std::string, std::string, std::string>>(
+                    [&](auto done) { ctx->riot->GetAccountAsync(name, tag, region, std::move(done)); });
+
+                if (std::get<0>(account).empty())
+                {
+                    event.edit_original_response(dpp::message("❌ Summoner not found. Check spelling and region code."));
+                    co_return;
+                }
+
                 Server::DB::User u;
-                u.discord_id = user.id;
+                u.discord_id = discordId;
                 u.riot_puuid = std::get<0>(account);
                 u.riot_name = std::get<1>(account);
                 u.riot_tag = std::get<2>(account);
                 u.region = region;
-                u.mult_lower = ctx->db->GetUserMultiplier(user.id, "lower");
-                u.mult_upper = ctx->db->GetUserMultiplier(user.id, "upper");
-                u.mult_core = ctx->db->GetUserMultiplier(user.id, "core");
+                u.mult_lower = ctx->db->GetUserMultiplier(discordId, "lower");
+                u.mult_upper = ctx->db->GetUserMultiplier(discordId, "upper");
+                u.mult_core = ctx->db->GetUserMultiplier(discordId, "core");
 
                 ctx->db->AddUser(u);
-                event.edit_original_response(
-                    dpp::message("✅ Linked **" + u.riot_name + "#" + u.riot_tag + "** to your Discord ID."));
+                event.edit_original_response(dpp::message("✅ Linked **" + u.riot_name + "#" + u.riot_tag + "** to your Discord ID."));
             }
-            else
+            catch (const std::exception &e)
             {
-                event.edit_original_response(dpp::message("❌ Summoner not found. Check spelling and region code."));
+                event.edit_original_response(dpp::message("⚠️ Error executing command: " + std::string(e.what())));
             }
         }
     };
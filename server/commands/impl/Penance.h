@@ -1,5 +1,6 @@
 #pragma once
 #include "server/commands/CommandSystem.h"
+#include "server/database/WriteBehind.h"
 #include <algorithm>
 #include <cmath>
 #include <iomanip>
@@ -161,7 +162,8 @@ namespace Core::Commands::Impl
             event.edit_original_response(msg);
         }
 
-        void OnButton(const dpp::button_click_t &event, std::shared_ptr<Core::Utils::AppContext> ctx) override
+        void OnButton(const dpp::button_click_t &event, std::shared_ptr<Core::Utils::AppContext> ctx,
+                      Core::Discord::ComponentResponse &response) override
         {
             // ID Format: penance_prev_0 or penance_next_1
             std::string id = event.custom_id;
@@ -198,15 +200,16 @@ namespace Core::Commands::Impl
             dpp::message msg = BuildMessage(tasks, newPage);
 
             // Interaction update (replaces the message that spawned the button click)
-            event.reply(dpp::ir_update_message, msg);
+            response.Update(msg);
         }
 
-        void OnSelect(const dpp::select_click_t &event, std::shared_ptr<Core::Utils::AppContext> ctx) override
+        void OnSelect(const dpp::select_click_t &event, std::shared_ptr<Core::Utils::AppContext> ctx,
+                      Core::Discord::ComponentResponse &response) override
         {
             // Always acknowledge interaction
             if (event.values.empty()) 
             {
-               event.reply(dpp::ir_update_message, dpp::message("❌ Invalid selection")); 
+               response.Update(dpp::message("❌ Invalid selection")); 
                return;
             }
 
@@ -221,7 +224,17 @@ namespace Core::Commands::Impl
                 auto task = ctx->db->GetPenanceByGameID(user.id, gameId);
                 if (task)
                 {
-                    ctx->db->CompletePenance(user.id, gameId);
+                    if (ctx->dbWriter)
+                    {
+                        // Queued behind the tracker's pending writes; the list below must already show it done
+                        int64_t userId = user.id;
+                        ctx->dbWriter->Submit([userId, gameId](Server::DB::Database &db) { db.CompletePenance(userId, gameId); });
+                        ctx->dbWriter->Flush();
+                    }
+                    else
+                    {
+                        ctx->db->CompletePenance(user.id, gameId);
+                    }
                     actionTaken = true;
                 }
             }
@@ -249,7 +262,7 @@ namespace Core::Commands::Impl
             
             // If we successfully did something, we update. 
             // If the task was missing, we still update (it disappears from list).
-            event.reply(dpp::ir_update_message, msg);
+            response.Update(msg);
         }
     };
 } // namespace Core::Commands::Impl
\ No newline at end of file
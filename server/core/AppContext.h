@@ -2,23 +2,57 @@
 
 #include "server/database/Database.h"
 #include "server/riot/RiotClient.h"
+#include <atomic>
+#include <chrono>
 #include <dpp/dpp.h>
 #include <functional>
 #include <memory>
 
+namespace Server::DB
+{
+    class WriteBehind;
+} // namespace Server::DB
+
+namespace Core::Tracker
+{
+    class PollSchedule;
+    class TrackerPipeline;
+} // namespace Core::Tracker
+
 namespace Core::Utils
 {
-    // Forward declaration of Task to avoid circular include of TaskManager
+    // Forward declarations to avoid circular include of TaskManager
     class Task;
+    class UserCheckRegistry;
 
     // Shared Resources passed to tasks and commands
     struct AppContext
     {
         std::shared_ptr<dpp::cluster> bot;
         std::shared_ptr<Server::DB::Database> db;
+        // Write-behind queue for tracker persistence; null = tracker writes synchronously
+        std::shared_ptr<Server::DB::WriteBehind> dbWriter;
         std::shared_ptr<Server::Riot::RiotClient> riot;
 
         // Helper to add tasks back to queue (implementation in TaskManager)
         std::function<void(std::unique_ptr<Task>)> submitTask;
+
+        // Capacity-checked submit; returns false (leaving the task with the caller) if its priority class is full
+        std::function<bool(std::unique_ptr<Task> &)> trySubmitTask;
+
+        // Submits a task once the delay has passed, without holding a worker in the meantime
+        std::function<void(std::chrono::steady_clock::duration, std::unique_ptr<Task>)> submitAfter;
+
+        // User checks queued or running from the current tracker sweep (admission control for new sweeps)
+        std::atomic<size_t> pendingUserChecks{0};
+
+        // Coalesces concurrent checks of the same Riot account
+        std::shared_ptr<UserCheckRegistry> userChecks;
+
+        // Staged tracker engine; set when tracker_engine = "pipeline", replacing the per-account check tasks
+        std::shared_ptr<Core::Tracker::TrackerPipeline> tracker;
+
+        // Per-account poll cadence; routine sweeps only poll the accounts it reports as due
+        std::shared_ptr<Core::Tracker::PollSchedule> pollSchedule;
     };
 } // namespace Core::Utils
\ No newline at end of file
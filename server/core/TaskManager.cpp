@@ -1,5 +1,9 @@
 #include "server/core/TaskManager.h"
 #include "server/commands/CommandSystem.h"
+#include "server/database/WriteBehind.h"
+#include "server/tracker/MatchRecorder.h"
+#include "server/tracker/PollSchedule.h"
+#include "server/tracker/TrackerPipeline.h"
 #include <algorithm>
 #include <iomanip>
 #include <iostream>
@@ -8,30 +12,181 @@
 
 namespace Core::Utils
 {
-    TaskManager::TaskManager(size_t num_threads, std::shared_ptr<AppContext> context) : m_done(false), m_ctx(context)
+    namespace
+    {
+        // Identifies the pool (and slot) the current thread works for, so submit() can route to the local deque.
+        thread_local const void *t_pool = nullptr;
+        thread_local size_t t_workerIndex = 0;
+
+        size_t ClassIndex(TaskPriority priority) { return static_cast<size_t>(priority); }
+
+        int64_t NowTicks() { return std::chrono::steady_clock::now().time_since_epoch().count(); }
+
+        const char *ClassName(size_t cls)
+        {
+            static const char *names[] = {"Low", "Standard", "High"};
+            return names[cls];
+        }
+    } // namespace
+
+    SchedulerMode ParseSchedulerMode(const std::string &name)
+    {
+        if (name == "work_stealing")
+        {
+            // No multi-core measurements back it yet (bench_task_manager throughput)
+            std::cout << "[TaskManager] Using the experimental work_stealing scheduler" << std::endl;
+            return SchedulerMode::WorkStealing;
+        }
+        if (name != "shared")
+            std::cerr << "Unknown thread_pool_scheduler '" << name << "', using 'shared'" << std::endl;
+        return SchedulerMode::Shared;
+    }
+
+    TaskManager::TaskManager(const TaskManagerOptions &options, std::shared_ptr<AppContext> context)
+        : m_options(options), m_done(false), m_ctx(context)
     {
         m_ctx->submitTask = [this](std::unique_ptr<Task> t) { this->submit(std::move(t)); };
+        m_ctx->trySubmitTask = [this](std::unique_ptr<Task> &t) { return this->try_submit(t); };
+        m_ctx->submitAfter = [this](Clock::duration delay, std::unique_ptr<Task> t) { this->submit_after(delay, std::move(t)); };
+
+        m_highQueue.attach(&m_signal);
+        m_stdQueue.attach(&m_signal);
+        m_lowQueue.attach(&m_signal);
+
+        if (m_options.scheduler == SchedulerMode::WorkStealing)
+        {
+            for (size_t i = 0; i < m_options.num_threads; ++i)
+                m_local.push_back(std::make_unique<WorkerDeque>());
+        }
+
+        int64_t now = NowTicks();
+        for (auto &servedAt : m_servedAt)
+            servedAt = now;
+        m_nextStatsLog = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(m_options.stats_interval).count();
 
-        for (size_t i = 0; i < num_threads; ++i)
+        for (size_t i = 0; i < m_options.num_threads; ++i)
         {
-            m_workers.emplace_back(&TaskManager::WorkerLoop, this);
+            m_workers.emplace_back(&TaskManager::WorkerLoop, this, i);
         }
+        m_timerThread = std::thread(&TaskManager::TimerLoop, this);
     }
 
     TaskManager::~TaskManager()
     {
+        // Timers first, so nothing fires into a pool that is shutting down
+        {
+            std::lock_guard<std::mutex> lock(m_timerMutex);
+            m_timersStopped = true;
+        }
+        m_timerCv.notify_all();
+        if (m_timerThread.joinable())
+            m_timerThread.join();
+
         m_done = true;
+        m_signal.notify_all();
         for (auto &worker : m_workers)
         {
             if (worker.joinable())
                 worker.join();
         }
+
+        // Tasks still queued are destroyed with the queues; coroutine frames among them may try to
+        // submit follow-up work from their destructors, which must not reach this dead pool.
+        m_ctx->submitTask = [](std::unique_ptr<Task>) {};
+        m_ctx->trySubmitTask = [](std::unique_ptr<Task> &) { return false; };
+        m_ctx->submitAfter = [](Clock::duration, std::unique_ptr<Task>) {};
+
+        // Same for tasks still waiting on a timer
+        std::unordered_map<TimerId, Timer> timers;
+        {
+            std::lock_guard<std::mutex> lock(m_timerMutex);
+            timers.swap(m_timers);
+        }
     }
 
     void TaskManager::submit(std::unique_ptr<Task> task)
     {
         if (!task)
             return;
+
+        // Counted before the push so the count never trails the queues
+        size_t cls = ClassIndex(task->priority);
+        NoteDepth(cls, m_queued[cls].fetch_add(1) + 1);
+        Enqueue(std::move(task));
+    }
+
+    bool TaskManager::try_submit(std::unique_ptr<Task> &task)
+    {
+        if (!task)
+            return false;
+
+        // Reserve a slot first; the CAS keeps concurrent submitters from overshooting the capacity
+        size_t cls = ClassIndex(task->priority);
+        size_t cap = m_options.capacity[cls];
+        size_t depth = m_queued[cls].load();
+        do
+        {
+            if (cap != 0 && depth >= cap)
+            {
+                if (m_rejected[cls].fetch_add(1) == 0)
+                    std::cerr << "[TaskManager] " << ClassName(cls) << " queue full (" << cap << "), rejecting new tasks"
+                              << std::endl;
+                return false;
+            }
+        } while (!m_queued[cls].compare_exchange_weak(depth, depth + 1));
+
+        NoteDepth(cls, depth + 1);
+        Enqueue(std::move(task));
+        return true;
+    }
+
+    void TaskManager::NoteDepth(size_t cls, size_t depth)
+    {
+        // A class that was idle restarts its aging clock, otherwise its first task would look starved
+        if (depth == 1)
+            m_servedAt[cls] = NowTicks();
+
+        size_t highWater = m_highWater[cls].load();
+        while (depth > highWater && !m_highWater[cls].compare_exchange_weak(highWater, depth))
+        {
+        }
+
+        // Log every time the backlog doubles past 64 so growth is visible without flooding the log
+        size_t logged = m_loggedHighWater[cls].load();
+        if (depth >= 64 && depth >= 2 * logged && m_loggedHighWater[cls].compare_exchange_strong(logged, depth))
+        {
+            std::cout << "[TaskManager] " << ClassName(cls) << " queue high-water mark: " << depth;
+            if (m_options.capacity[cls] != 0)
+                std::cout << " / " << m_options.capacity[cls];
+            std::cout << std::endl;
+        }
+    }
+
+    void TaskManager::Enqueue(std::unique_ptr<Task> task)
+    {
+        task->enqueued_at = std::chrono::steady_clock::now();
+
+        // Work-stealing: tasks spawned by one of our workers (e.g. the tracker fan-out) stay on its own deque.
+        // High tasks and anything with a deadline (interactions, their coroutine resumes) always go through
+        // the global queues, where the High queue dispatches earliest deadline first; a local deque is LIFO.
+        bool local = task->priority != TaskPriority::High && task->deadline == std::chrono::steady_clock::time_point::max();
+        if (m_options.scheduler == SchedulerMode::WorkStealing && t_pool == this && local)
+        {
+            size_t cls = ClassIndex(task->priority);
+            {
+                std::lock_guard<std::mutex> lock(m_local[t_workerIndex]->mutex);
+                m_local[t_workerIndex]->tasks[cls].push_back(std::move(task));
+            }
+            m_localCount[cls].fetch_add(1);
+            m_signal.notify_one(); // let an idle sibling steal
+            return;
+        }
+
+        PushGlobal(std::move(task));
+    }
+
+    void TaskManager::PushGlobal(std::unique_ptr<Task> task)
+    {
         switch (task->priority)
         {
         case TaskPriority::High:
@@ -41,11 +196,26 @@ namespace Core::Utils
             m_stdQueue.push(std::move(task));
             break;
         case TaskPriority::Low:
+        default:
             m_lowQueue.push(std::move(task));
             break;
         }
     }
 
+    bool TaskManager::PopGlobal(TaskPriority priority, std::unique_ptr<Task> &task)
+    {
+        switch (priority)
+        {
+        case TaskPriority::High:
+            return m_highQueue.try_pop(task);
+        case TaskPriority::Standard:
+            return m_stdQueue.try_pop(task);
+        case TaskPriority::Low:
+        default:
+            return m_lowQueue.try_pop(task);
+        }
+    }
+
     // -------------------------------------------------------------------------
     // SLASH COMMAND PROCESSING
     // -------------------------------------------------------------------------
@@ -58,6 +228,8 @@ namespace Core::Utils
         {
             try
             {
+                // Whoever uses the bot in a server shows up on that server's leaderboards
+                ctx->db->RecordGuildMember(event.command.guild_id, event.command.get_issuing_user().id);
                 cmd->Execute(event, ctx);
             }
             catch (const std::exception &e)
@@ -92,7 +264,7 @@ namespace Core::Utils
             {
                 try
                 {
-                    cmd->OnButton(event, ctx);
+                    cmd->OnButton(event, ctx, *response);
                 }
                 catch (const std::exception &e)
                 {
@@ -122,7 +294,7 @@ namespace Core::Utils
             {
                 try
                 {
-                    cmd->OnSelect(event, ctx);
+                    cmd->OnSelect(event, ctx, *response);
                 }
                 catch (const std::exception &e)
                 {
@@ -137,127 +309,854 @@ namespace Core::Utils
     // -------------------------------------------------------------------------
     void TaskTrackerUpdate::process()
     {
+        // Admission control without a poll schedule: while the previous sweep is still draining, its queued
+        // checks will pick up any new matches anyway, so a second routine sweep would only duplicate stale work.
+        // Forced sweeps (higher check priority) go ahead and merge into the in-flight checks instead.
+        // With a schedule, admission is per account (below), so one slow check doesn't hold up every other
+        // account that falls due. The pipeline engine does its own per-account admission.
+        size_t pending = ctx->pendingUserChecks.load();
+        if (!ctx->tracker && !ctx->pollSchedule && pending > 0 && checkPriority == TaskPriority::Low)
+        {
+            std::cout << "[Tracker] Previous sweep still draining (" << pending << " checks left), skipping this one" << std::endl;
+            return;
+        }
+
+        // Group Discord links by Riot account so a shared/duo account is polled once per sweep
         auto users = ctx->db->GetAllUsers();
-        for (const auto &user : users)
+        std::vector<std::vector<Server::DB::User>> accounts;
+        std::unordered_map<std::string, size_t> accountIndex;
+        for (auto &user : users)
         {
-            auto task = std::make_unique<TaskCheckUserMatch>();
-            task->ctx = ctx;
-            task->user = user;
-            task->priority = TaskPriority::Low;
-            ctx->submitTask(std::move(task));
+            auto [it, inserted] = accountIndex.emplace(user.riot_puuid + "|" + user.region, accounts.size());
+            if (inserted)
+                accounts.emplace_back();
+            accounts[it->second].push_back(std::move(user));
         }
+
+        // Routine sweeps poll only the accounts whose interval is up; forced sweeps poll everyone
+        if (ctx->pollSchedule && checkPriority == TaskPriority::Low)
+            accounts = ctx->pollSchedule->Due(std::move(accounts));
+
+        if (ctx->tracker)
+        {
+            ctx->tracker->Sweep(accounts);
+            return;
+        }
+
+        // A routine poll of an account whose check is still queued or running is redundant: that check
+        // reports back to the schedule when it ends
+        if (ctx->pollSchedule && checkPriority == TaskPriority::Low)
+        {
+            std::erase_if(accounts, [&](const std::vector<Server::DB::User> &links)
+                          { return ctx->userChecks->InFlight(Core::Tracker::PollSchedule::Key(links.front())); });
+        }
+
+        size_t deferred = 0;
+        for (size_t i = 0; i < accounts.size(); ++i)
+        {
+            if (!ctx->userChecks->Schedule(ctx, accounts[i], checkPriority))
+            {
+                // Queue is full: leave the rest for the next sweep
+                deferred = accounts.size() - i;
+                if (ctx->pollSchedule)
+                {
+                    for (size_t j = i; j < accounts.size(); ++j)
+                        ctx->pollSchedule->Retry(Core::Tracker::PollSchedule::Key(accounts[j].front()));
+                }
+                break;
+            }
+        }
+
+        if (deferred > 0)
+            std::cerr << "[Tracker] Queue full, deferred " << deferred << " account checks to the next sweep" << std::endl;
     }
 
+    // -------------------------------------------------------------------------
+    // USER CHECK DEDUPLICATION
+    // -------------------------------------------------------------------------
+    bool UserCheckRegistry::Schedule(const std::shared_ptr<AppContext> &ctx, const std::vector<Server::DB::User> &links,
+                                     TaskPriority priority)
+    {
+        if (links.empty())
+            return true;
+
+        auto mergeLinks = [&](Ticket &ticket) {
+            for (const auto &user : links)
+            {
+                auto link = std::find_if(ticket.users.begin(), ticket.users.end(),
+                                         [&](const Server::DB::User &u) { return u.discord_id == user.discord_id; });
+                if (link != ticket.users.end())
+                    *link = user; // refresh multipliers
+                else
+                    ticket.users.push_back(user);
+            }
+        };
+
+        std::shared_ptr<Ticket> ticket;
+        bool created = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::string key = links.front().riot_puuid + "|" + links.front().region;
+            auto it = m_tickets.find(key);
+            if (it != m_tickets.end())
+            {
+                ticket = it->second;
+                mergeLinks(*ticket);
+
+                if (ticket->running)
+                {
+                    // The running check may already have fetched its match list
+                    ticket->rerun = true;
+                    ticket->priority = std::max(ticket->priority, priority);
+                    return true;
+                }
+                if (priority <= ticket->priority)
+                    return true;
+
+                ticket->priority = priority;
+            }
+            else
+            {
+                ticket = std::make_shared<Ticket>();
+                ticket->key = key;
+                mergeLinks(*ticket);
+                ticket->priority = priority;
+                m_tickets[key] = ticket;
+                created = true;
+            }
+        }
+
+        // New check, or a priority raise: queue a copy at the new priority. Whichever copy runs
+        // first claims the ticket. A rejected raise is harmless since the original copy is still queued.
+        if (SubmitCopy(ctx, ticket, priority))
+            return true;
+        if (!created)
+            return true;
+
+        // Queue full: forget the new ticket unless a concurrent raise already queued its own copy
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!ticket->running && ticket->priority == priority)
+            Drop(ticket);
+        return false;
+    }
+
+    bool UserCheckRegistry::InFlight(const std::string &key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_tickets.count(key) > 0;
+    }
+
+    bool UserCheckRegistry::Claim(const std::shared_ptr<Ticket> &ticket)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (ticket->done || ticket->running)
+            return false;
+        ticket->running = true;
+        return true;
+    }
+
+    std::vector<Server::DB::User> UserCheckRegistry::Users(const std::shared_ptr<Ticket> &ticket)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return ticket->users;
+    }
+
+    void UserCheckRegistry::Finish(const std::shared_ptr<AppContext> &ctx, const std::shared_ptr<Ticket> &ticket)
+    {
+        TaskPriority priority;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ticket->running = false;
+            if (!ticket->rerun)
+            {
+                Drop(ticket);
+                return;
+            }
+            ticket->rerun = false;
+            priority = ticket->priority;
+        }
+
+        if (!SubmitCopy(ctx, ticket, priority))
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!ticket->running)
+                Drop(ticket);
+        }
+    }
+
+    bool UserCheckRegistry::SubmitCopy(const std::shared_ptr<AppContext> &ctx, const std::shared_ptr<Ticket> &ticket,
+                                       TaskPriority priority)
+    {
+        auto check = std::make_unique<TaskCheckUserMatch>();
+        check->ctx = ctx;
+        check->ticket = ticket;
+        check->priority = priority;
+        ctx->pendingUserChecks++; // Released by ~TaskCheckUserMatch, including when rejected below
+
+        std::unique_ptr<Task> task = std::move(check);
+        return ctx->trySubmitTask(task);
+    }
+
+    // Caller holds m_mutex
+    void UserCheckRegistry::Drop(const std::shared_ptr<Ticket> &ticket)
+    {
+        ticket->done = true;
+        auto it = m_tickets.find(ticket->key);
+        if (it != m_tickets.end() && it->second == ticket)
+            m_tickets.erase(it);
+    }
+
+    // -------------------------------------------------------------------------
+    // COROUTINE TASKS
+    // -------------------------------------------------------------------------
+    void CoTask::promise_type::unhandled_exception()
+    {
+        try
+        {
+            throw;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "CRITICAL: Coroutine Task Exception: " << e.what() << std::endl;
+        }
+        catch (...)
+        {
+            std::cerr << "CRITICAL: Coroutine Task Unknown Exception" << std::endl;
+        }
+    }
+
+    CoTask::~CoTask()
+    {
+        // Never started: nobody else will free the frame
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    void CoTask::Start(std::shared_ptr<AppContext> ctx, TaskPriority priority)
+    {
+        auto handle = std::exchange(m_handle, {});
+        handle.promise().ctx = std::move(ctx);
+        handle.promise().priority = priority;
+        handle.resume();
+    }
+
+    void ResumeOnPool(CoTask::Handle handle)
+    {
+        // Copy the context first: once submitted, another worker may resume (and free) the frame
+        auto ctx = handle.promise().ctx;
+        ctx->submitTask(std::make_unique<TaskResume>(handle));
+    }
+
+    TaskResume::TaskResume(CoTask::Handle handle) : m_handle(handle)
+    {
+        priority = handle.promise().priority;
+        type = TaskType::COROUTINE_RESUME;
+    }
+
+    TaskResume::~TaskResume()
+    {
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    void TaskResume::process() { std::exchange(m_handle, {}).resume(); }
+
     // -------------------------------------------------------------------------
     // INDIVIDUAL USER MATCH CHECK (ROBUST LOGIC)
     // -------------------------------------------------------------------------
+    TaskCheckUserMatch::~TaskCheckUserMatch()
+    {
+        // Released on destruction so checks dropped without running (full queue, shutdown) are counted too.
+        // Once the coroutine has started, its frame releases the slot instead.
+        if (ctx && !m_started)
+            ctx->pendingUserChecks--;
+    }
+
     void TaskCheckUserMatch::process()
     {
-        // 1. Fetch last 15 matches (Riot defaults to Newest -> Oldest)
-        auto matches = ctx->riot->GetLastMatches(user.riot_puuid, user.region, 15);
+        if (!ticket || !ctx->userChecks->Claim(ticket))
+            return; // A sibling copy (queued before a priority raise) already handled this account
+
+        m_started = true;
+        CheckAccount(ctx, ticket).Start(ctx, priority);
+    }
+
+    // Every link on the ticket is the same Riot account linked by a different Discord user, so the match
+    // list and each match payload are fetched once and the result fans out to every link.
+    CoTask TaskCheckUserMatch::CheckAccount(std::shared_ptr<AppContext> ctx, std::shared_ptr<UserCheckRegistry::Ticket> ticket)
+    {
+        // Always release the ticket and the pending slot, even if a Riot/DB call throws or the
+        // frame is destroyed while suspended. Shared with the write-behind queue, so the account only
+        // counts as checked once its matches are stored and a new check can't record them twice.
+        struct FinishGuard
+        {
+            std::shared_ptr<AppContext> ctx;
+            std::shared_ptr<UserCheckRegistry::Ticket> ticket;
+            ~FinishGuard()
+            {
+                ctx->userChecks->Finish(ctx, ticket);
+                ctx->pendingUserChecks--;
+            }
+        };
+        std::shared_ptr<FinishGuard> guard(new FinishGuard{ctx, ticket});
+
+        const auto links = ctx->userChecks->Users(ticket);
+        if (links.empty())
+            co_return;
+        const auto &account = links.front();
+
+        // 1. Fetch the matches since the account's cursor (Riot returns Newest -> Oldest, page by page).
+        // The worker is free while we wait; a quiet account costs one request and no DB lookups.
+        Core::Tracker::PollProgress progress;
+        std::vector<std::string> matches;
+        std::optional<Server::Riot::MatchListQuery> page = Core::Tracker::FirstMatchListPage(Core::Tracker::AccountCursor(links));
+        while (page)
+        {
+            auto ids = co_await Async<std::optional<std::vector<std::string>>>(
+                [&](auto done) { ctx->riot->GetLastMatchesAsync(account.riot_puuid, account.region, *page, std::move(done)); });
+            if (!ids)
+            {
+                progress.failed = true;
+                break;
+            }
+            matches.insert(matches.end(), ids->begin(), ids->end());
+            page = Core::Tracker::NextMatchListPage(*page, ids->size(), progress);
+        }
+
+        // A failed page leaves a gap we can't see past; the cursors stay and the next poll lists it all again.
+        // It is no sign of a quiet account (more likely a Riot outage or rate limiting), so retry on the next
+        // tick instead of backing off.
+        if (progress.failed)
+        {
+            std::cerr << "[Tracker] Failed to list matches for " << account.riot_name << ", will retry" << std::endl;
+            if (ctx->pollSchedule)
+                ctx->pollSchedule->Retry(Core::Tracker::PollSchedule::Key(account));
+            co_return;
+        }
 
         if (matches.empty())
-            return;
+        {
+            if (ctx->pollSchedule)
+                ctx->pollSchedule->Report(Core::Tracker::PollSchedule::Key(account), false);
+            co_return;
+        }
 
-        // 2. Reverse to process Oldest -> Newest
-        std::reverse(matches.begin(), matches.end());
+        // 2. Oldest -> Newest, at most one poll's worth
+        Core::Tracker::PrepareMatchList(matches, progress, account.riot_name);
 
         // 3. Iterate and check against DB
+        std::vector<AnalyzedMatch> analyzed;
         for (const auto &match_id : matches)
         {
-            if (ctx->db->IsMatchProcessed(user.discord_id, match_id))
+            std::vector<Server::DB::User> pending;
+            for (const auto &user : links)
+            {
+                if (auto end = ctx->db->GetProcessedMatchEnd(user.discord_id, match_id))
+                    progress.Saw(match_id, *end);
+                else
+                    pending.push_back(user);
+            }
+            if (pending.empty())
             {
-                continue; // Already processed, skip it.
+                continue; // Already processed for everyone, skip it.
             }
+            progress.new_matches++;
 
-            // 4. It's a new match! Analyze it.
-            auto stats = ctx->riot->AnalyzeMatch(match_id, user.riot_puuid, user.region);
+            // 4. It's a new match! Analyze it (once for all links).
+            auto stats = co_await Async<Server::Riot::MatchStats>(
+                [&](auto done) { ctx->riot->AnalyzeMatchAsync(match_id, account.riot_puuid, account.region, std::move(done)); });
 
-            if (stats.valid)
+            if (!stats.valid)
             {
-                ctx->db->LogGame(user.discord_id, match_id, stats.timestamp, stats.gameDuration, stats.champion_name, stats.kills, stats.deaths,
-                                 stats.assists, stats.kp_percent, stats.cs, stats.cs_min);
+                std::cerr << "Failed to analyze match " << match_id << " for user " << account.riot_name << std::endl;
+                progress.failed = true;
+                continue;
+            }
 
-                if (stats.deaths > 0)
-                {
-                    auto exOpt = ctx->db->GetRandomExercise();
-                    std::string exName = "Pushups";
-                    int baseReps = 10;
-                    std::string type = "upper";
+            progress.Saw(match_id, Core::Tracker::MatchEndTime(stats));
+            analyzed.push_back(AnalyzedMatch{match_id, std::move(stats), std::move(pending)});
+        }
 
-                    if (exOpt)
-                    {
-                        exName = exOpt->name;
-                        baseReps = exOpt->set_count;
-                        type = exOpt->type;
-                    }
+        // 5. Record the new matches and move the cursors past everything seen (unless a match has to be
+        // retried next sweep), all in one commit. With the write-behind queue this returns right away.
+        PersistPoll(*ctx, links, std::move(analyzed), progress, guard);
 
-                    double multiplier = 1.0;
-                    if (type == "lower")
-                        multiplier = user.mult_lower;
-                    else if (type == "core")
-                        multiplier = user.mult_core;
-                    else
-                        multiplier = user.mult_upper;
+        // 6. Poll again soon if the account is playing, less often the longer it stays quiet
+        if (ctx->pollSchedule)
+            ctx->pollSchedule->Report(Core::Tracker::PollSchedule::Key(account), progress.new_matches > 0);
+    }
 
-                    int totalReps = static_cast<int>(stats.deaths * baseReps * multiplier);
-                    if (totalReps < 1)
-                        totalReps = 1;
+    std::optional<TaskCheckUserMatch::Notifications> TaskCheckUserMatch::RecordPoll(
+        Server::DB::Database &db, const std::vector<Server::DB::User> &links, const std::vector<AnalyzedMatch> &analyzed,
+        const Core::Tracker::PollProgress &progress)
+    {
+        Notifications notifications;
+        Server::DB::Database::Transaction tx(db);
+        for (const auto &match : analyzed)
+        {
+            for (const auto &user : match.pending)
+            {
+                std::optional<std::string> notification;
+                if (!Core::Tracker::RecordMatch(db, user, match.match_id, match.stats, notification))
+                    return std::nullopt; // Rolls the whole poll back, cursors included
+                if (notification)
+                    notifications.emplace_back(user.discord_id, std::move(*notification));
+            }
+        }
+        Core::Tracker::AdvanceCursors(db, links, progress);
 
-                    ctx->db->AddToQueue(user.discord_id, match_id, exName, totalReps, stats.deaths);
+        if (!tx.Commit())
+            return std::nullopt;
+        return notifications;
+    }
 
-                    ctx->bot->direct_message_create(
-                        user.discord_id, dpp::message("💀 **New Match Detected** (" + user.riot_name +
-                                                      ")\nDeaths: " + std::to_string(stats.deaths) + "\nPenance: " +
-                                                      std::to_string(totalReps) + " " + exName + " (" + type + ")"));
-                }
-                ctx->db->UpdateLastMatch(user.discord_id, user.riot_puuid, match_id);
-            }
-            else
+    void TaskCheckUserMatch::PersistPoll(AppContext &ctx, const std::vector<Server::DB::User> &links, std::vector<AnalyzedMatch> analyzed,
+                                         const Core::Tracker::PollProgress &progress, std::shared_ptr<void> hold)
+    {
+        // Only announce penance that is actually stored. On failure nothing was kept and the cursors
+        // didn't move, so the next poll fetches these matches again.
+        auto announce = [bot = ctx.bot, name = links.empty() ? std::string("?") : links.front().riot_name,
+                         count = analyzed.size()](const std::optional<Notifications> &notifications)
+        {
+            if (!notifications)
             {
-                std::cerr << "Failed to analyze match " << match_id << " for user " << user.riot_name << std::endl;
+                std::cerr << "[Tracker] Failed to record " << count << " match(es) for " << name << std::endl;
+                return;
             }
+            for (const auto &[discord_id, message] : *notifications)
+                bot->direct_message_create(discord_id, dpp::message(message));
+        };
+
+        if (!ctx.dbWriter)
+        {
+            announce(RecordPoll(*ctx.db, links, analyzed, progress));
+            return;
         }
+
+        // Fire and forget: the writer thread stores it with whatever else is queued, and `hold` keeps the
+        // account checked-out until then
+        auto result = std::make_shared<std::optional<Notifications>>();
+        ctx.dbWriter->Submit(
+            [result, links, analyzed = std::move(analyzed), progress](Server::DB::Database &db)
+            { *result = RecordPoll(db, links, analyzed, progress); },
+            [result, announce, hold = std::move(hold)](bool committed)
+            {
+                if (!committed)
+                    result->reset();
+                announce(*result);
+            });
     }
 
     // -------------------------------------------------------------------------
     // WORKER LOOP
     // -------------------------------------------------------------------------
-    void TaskManager::WorkerLoop()
+    void TaskManager::WorkerLoop(size_t index)
     {
+        t_pool = this;
+        t_workerIndex = index;
+
         while (!m_done)
         {
             std::unique_ptr<Task> task;
-            if (TryPopWeighted(task))
+            if (!TryPopWeighted(task))
             {
-                try
+                // Register as a waiter, then poll once more: a push racing with the first poll
+                // either shows up here or bumps the epoch so the wait returns immediately.
+                uint64_t seen = m_signal.prepare_wait();
+                if (!TryPopWeighted(task))
                 {
-                    task->process();
+                    m_signal.wait(seen, [this] { return m_done.load(); });
+                    continue;
                 }
-                catch (const std::exception &e)
+                m_signal.cancel_wait();
+            }
+
+            try
+            {
+                task->process();
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "CRITICAL: Worker Thread Exception: " << e.what() << std::endl;
+            }
+            catch (...)
+            {
+                std::cerr << "CRITICAL: Worker Thread Unknown Exception" << std::endl;
+            }
+
+            MaybeLogQueueStats();
+        }
+    }
+
+    bool TaskManager::TryPopWeighted(std::unique_ptr<Task> &task)
+    {
+        for (TaskPriority priority : PickOrder())
+        {
+            if (TryPopClass(priority, task))
+            {
+                m_queued[ClassIndex(priority)].fetch_sub(1);
+                RecordDispatch(*task);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Chooses which class to serve first. With one (or no) backlogged class this is plain strict
+    // priority. Otherwise a class starved past aging_threshold goes first, and failing that smooth
+    // weighted round-robin hands out slots in proportion to the weights (8:3:1 by default, so
+    // High keeps at least 2/3 of the slots and never waits behind more than a handful of tasks).
+    // The remaining classes follow in strict priority order as a fallback if the pick loses a race.
+    std::array<TaskPriority, 3> TaskManager::PickOrder()
+    {
+        std::array<TaskPriority, 3> order = {TaskPriority::High, TaskPriority::Standard, TaskPriority::Low};
+
+        std::array<bool, 3> backlogged{};
+        int backloggedCount = 0;
+        for (size_t c = 0; c < 3; ++c)
+        {
+            backlogged[c] = m_queued[c].load() > 0;
+            backloggedCount += backlogged[c] ? 1 : 0;
+        }
+        if (backloggedCount <= 1)
+            return order;
+
+        size_t pick = 3;
+
+        // 1. Aging: the most starved class wins; the CAS lets only one worker claim each promotion
+        int64_t now = NowTicks();
+        int64_t threshold = std::chrono::duration_cast<std::chrono::steady_clock::duration>(m_options.aging_threshold).count();
+        for (size_t c = 0; c < 2 && pick == 3; ++c)
+        {
+            int64_t servedAt = m_servedAt[c].load();
+            if (backlogged[c] && now - servedAt > threshold && m_servedAt[c].compare_exchange_strong(servedAt, now))
+                pick = c;
+        }
+
+        // 2. Smooth weighted round-robin over the backlogged classes
+        if (pick == 3)
+        {
+            std::lock_guard<std::mutex> lock(m_schedMutex);
+            int64_t total = 0;
+            for (size_t c = 0; c < 3; ++c)
+            {
+                if (!backlogged[c])
                 {
-                    std::cerr << "CRITICAL: Worker Thread Exception: " << e.what() << std::endl;
+                    m_credit[c] = 0;
+                    continue;
                 }
-                catch (...)
+                int64_t weight = std::max(1u, m_options.weights[c]);
+                m_credit[c] += weight;
+                total += weight;
+                if (pick == 3 || m_credit[c] >= m_credit[pick])
+                    pick = c; // ties go to the higher class
+            }
+            m_credit[pick] -= total;
+        }
+
+        std::array<TaskPriority, 3> picked = {static_cast<TaskPriority>(pick)};
+        size_t next = 1;
+        for (TaskPriority priority : order)
+        {
+            if (priority != picked[0])
+                picked[next++] = priority;
+        }
+        return picked;
+    }
+
+    void TaskManager::RecordDispatch(const Task &task)
+    {
+        auto now = std::chrono::steady_clock::now();
+        size_t cls = ClassIndex(task.priority);
+        m_servedAt[cls] = now.time_since_epoch().count();
+
+        uint64_t waitUs = std::chrono::duration_cast<std::chrono::microseconds>(now - task.enqueued_at).count();
+        size_t bucket = 0;
+        while (bucket + 1 < WaitHistogram::BUCKETS && (waitUs >> (bucket + 1)) != 0)
+            ++bucket;
+
+        auto &hist = m_waits[cls];
+        hist.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        hist.count.fetch_add(1, std::memory_order_relaxed);
+        hist.total_us.fetch_add(waitUs, std::memory_order_relaxed);
+        uint64_t prevMax = hist.max_us.load(std::memory_order_relaxed);
+        while (waitUs > prevMax && !hist.max_us.compare_exchange_weak(prevMax, waitUs, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    std::array<QueueClassStats, 3> TaskManager::GetQueueStats() const
+    {
+        std::array<QueueClassStats, 3> result;
+        for (size_t c = 0; c < 3; ++c)
+        {
+            const auto &hist = m_waits[c];
+            auto &out = result[c];
+            out.dispatched = hist.count.load(std::memory_order_relaxed);
+            out.queued = m_queued[c].load();
+            out.max_wait_ms = hist.max_us.load(std::memory_order_relaxed) / 1000.0;
+            out.high_water = m_highWater[c].load();
+            out.rejected = m_rejected[c].load();
+            if (out.dispatched == 0)
+                continue;
+            out.avg_wait_ms = hist.total_us.load(std::memory_order_relaxed) / 1000.0 / out.dispatched;
+
+            // Percentiles resolve to the upper bound of the bucket they fall in
+            uint64_t seen = 0;
+            uint64_t p50Rank = (out.dispatched + 1) / 2;
+            uint64_t p99Rank = out.dispatched - out.dispatched / 100;
+            for (size_t b = 0; b < WaitHistogram::BUCKETS; ++b)
+            {
+                uint64_t inBucket = hist.buckets[b].load(std::memory_order_relaxed);
+                if (inBucket == 0)
+                    continue;
+                seen += inBucket;
+                double upperMs = static_cast<double>(uint64_t(1) << (b + 1)) / 1000.0;
+                if (out.p50_wait_ms == 0.0 && seen >= p50Rank)
+                    out.p50_wait_ms = upperMs;
+                if (seen >= p99Rank)
                 {
-                    std::cerr << "CRITICAL: Worker Thread Unknown Exception" << std::endl;
+                    out.p99_wait_ms = upperMs;
+                    break;
                 }
             }
-            else
+        }
+        return result;
+    }
+
+    // -------------------------------------------------------------------------
+    // TIMERS
+    // -------------------------------------------------------------------------
+    TaskManager::TimerId TaskManager::submit_at(Clock::time_point when, std::unique_ptr<Task> task)
+    {
+        if (!task)
+            return 0;
+        Timer timer;
+        timer.task = std::move(task);
+        return AddTimer(when, std::move(timer));
+    }
+
+    TaskManager::TimerId TaskManager::submit_after(Clock::duration delay, std::unique_ptr<Task> task)
+    {
+        return submit_at(Clock::now() + delay, std::move(task));
+    }
+
+    TaskManager::TimerId TaskManager::run_at(Clock::time_point when, std::function<void()> fn)
+    {
+        if (!fn)
+            return 0;
+        Timer timer;
+        timer.callback = std::move(fn);
+        return AddTimer(when, std::move(timer));
+    }
+
+    TaskManager::TimerId TaskManager::submit_every(Clock::duration period, TaskFactory factory, Clock::duration initial_delay)
+    {
+        if (!factory || period <= Clock::duration::zero())
+            return 0;
+        Timer timer;
+        timer.factory = std::move(factory);
+        timer.period = period;
+        return AddTimer(Clock::now() + initial_delay, std::move(timer));
+    }
+
+    bool TaskManager::cancel_timer(TimerId id)
+    {
+        // The heap entry stays behind and is skipped when it comes up
+        std::unique_ptr<Task> task;
+        {
+            std::lock_guard<std::mutex> lock(m_timerMutex);
+            auto it = m_timers.find(id);
+            if (it == m_timers.end())
+                return false;
+            task = std::move(it->second.task);
+            m_timers.erase(it);
+        }
+        return true; // `task` is destroyed outside the lock; its destructor may submit work
+    }
+
+    size_t TaskManager::pending_timers() const
+    {
+        std::lock_guard<std::mutex> lock(m_timerMutex);
+        return m_timers.size();
+    }
+
+    TaskManager::TimerId TaskManager::AddTimer(Clock::time_point when, Timer timer)
+    {
+        TimerId id;
+        bool earliest;
+        {
+            std::lock_guard<std::mutex> lock(m_timerMutex);
+            if (m_timersStopped)
+                return 0;
+            id = m_nextTimerId++;
+            m_timers.emplace(id, std::move(timer));
+            earliest = m_timerHeap.empty() || when < m_timerHeap.top().when;
+            m_timerHeap.push(TimerSlot{when, id});
+        }
+        // The timer thread only needs to re-arm if the new timer is due before the one it sleeps on
+        if (earliest)
+            m_timerCv.notify_one();
+        return id;
+    }
+
+    void TaskManager::TimerLoop()
+    {
+        std::unique_lock<std::mutex> lock(m_timerMutex);
+        while (!m_timersStopped)
+        {
+            if (m_timerHeap.empty())
+            {
+                m_timerCv.wait(lock);
+                continue;
+            }
+
+            TimerSlot next = m_timerHeap.top();
+            auto now = Clock::now();
+            if (now < next.when)
+            {
+                m_timerCv.wait_until(lock, next.when);
+                continue;
+            }
+            m_timerHeap.pop();
+
+            auto it = m_timers.find(next.id);
+            if (it == m_timers.end())
+                continue; // Cancelled
+
+            if (it->second.period == Clock::duration::zero())
+            {
+                std::unique_ptr<Task> task = std::move(it->second.task);
+                std::function<void()> callback = std::move(it->second.callback);
+                m_timers.erase(it);
+                lock.unlock();
+                if (task)
+                {
+                    submit(std::move(task));
+                }
+                else
+                {
+                    try
+                    {
+                        callback();
+                    }
+                    catch (const std::exception &e)
+                    {
+                        std::cerr << "[TaskManager] Timer callback error: " << e.what() << std::endl;
+                    }
+                }
+                lock.lock();
+                continue;
+            }
+
+            // Recurring: book the next occurrence before firing this one. If we fell behind, restart
+            // the cadence from now instead of firing every missed occurrence back to back.
+            Clock::time_point following = next.when + it->second.period;
+            if (following <= now)
+                following = now + it->second.period;
+            m_timerHeap.push(TimerSlot{following, next.id});
+            TaskFactory factory = it->second.factory; // The timer may be cancelled while we are unlocked
+
+            lock.unlock();
+            try
             {
-                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                std::unique_ptr<Task> task = factory();
+                if (task && !try_submit(task))
+                    std::cerr << "[TaskManager] " << ClassName(ClassIndex(task->priority))
+                              << " queue full, skipping a recurring task" << std::endl;
             }
+            catch (const std::exception &e)
+            {
+                std::cerr << "[TaskManager] Recurring task factory error: " << e.what() << std::endl;
+            }
+            lock.lock();
         }
     }
 
-    bool TaskManager::TryPopWeighted(std::unique_ptr<Task> &task)
+    void TaskManager::MaybeLogQueueStats()
     {
-        if (m_highQueue.try_pop(task))
+        if (m_options.stats_interval.count() <= 0)
+            return;
+
+        int64_t now = NowTicks();
+        int64_t due = m_nextStatsLog.load();
+        int64_t interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(m_options.stats_interval).count();
+        if (now < due || !m_nextStatsLog.compare_exchange_strong(due, now + interval))
+            return;
+
+        auto stats = GetQueueStats();
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(2) << "[TaskManager] Queue wait (last " << m_options.stats_interval.count() << "s)";
+        for (size_t c = 3; c-- > 0;)
+        {
+            const auto &st = stats[c];
+            ss << " | " << ClassName(c) << ": n=" << st.dispatched << " avg=" << st.avg_wait_ms << "ms p50<=" << st.p50_wait_ms
+               << "ms p99<=" << st.p99_wait_ms << "ms max=" << st.max_wait_ms << "ms queued=" << st.queued
+               << " hwm=" << st.high_water << " rejected=" << st.rejected;
+        }
+        ss << " | timers=" << pending_timers();
+        std::cout << ss.str() << std::endl;
+
+        // Start a fresh window
+        for (auto &hist : m_waits)
+        {
+            for (auto &bucket : hist.buckets)
+                bucket.store(0, std::memory_order_relaxed);
+            hist.count.store(0, std::memory_order_relaxed);
+            hist.total_us.store(0, std::memory_order_relaxed);
+            hist.max_us.store(0, std::memory_order_relaxed);
+        }
+        for (size_t c = 0; c < 3; ++c)
+        {
+            m_highWater[c] = m_queued[c].load();
+            m_rejected[c] = 0;
+        }
+    }
+
+    bool TaskManager::TryPopClass(TaskPriority priority, std::unique_ptr<Task> &task)
+    {
+        if (m_options.scheduler == SchedulerMode::Shared)
+            return PopGlobal(priority, task);
+
+        // Own deque first, then the injection queue, then other workers
+        if (PopLocal(priority, task))
             return true;
-        if (m_stdQueue.try_pop(task))
+        if (PopGlobal(priority, task))
             return true;
-        if (m_lowQueue.try_pop(task))
+        return Steal(priority, task);
+    }
+
+    bool TaskManager::PopLocal(TaskPriority priority, std::unique_ptr<Task> &task)
+    {
+        size_t cls = ClassIndex(priority);
+        if (m_localCount[cls].load() == 0)
+            return false;
+
+        auto &local = *m_local[t_workerIndex];
+        std::lock_guard<std::mutex> lock(local.mutex);
+        if (local.tasks[cls].empty())
+            return false;
+        task = std::move(local.tasks[cls].back());
+        local.tasks[cls].pop_back();
+        m_localCount[cls].fetch_sub(1);
+        return true;
+    }
+
+    bool TaskManager::Steal(TaskPriority priority, std::unique_ptr<Task> &task)
+    {
+        size_t cls = ClassIndex(priority);
+        size_t n = m_local.size();
+        for (size_t i = 1; i < n && m_localCount[cls].load() > 0; ++i)
+        {
+            auto &victim = *m_local[(t_workerIndex + i) % n];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.tasks[cls].empty())
+                continue;
+            task = std::move(victim.tasks[cls].front());
+            victim.tasks[cls].pop_front();
+            m_localCount[cls].fetch_sub(1);
             return true;
+        }
         return false;
     }
 } // namespace Core::Utils
\ No newline at end of file
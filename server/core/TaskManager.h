@@ -2,8 +2,24 @@
 
 #include "server/core/AppContext.h" // Includes DB, Riot, DPP
 #include "server/core/ThreadsafeQueue.h"
+#include "server/discord/ComponentResponse.h"
+#include "server/tracker/MatchRecorder.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <variant>
+#include <vector>
 
 namespace Core::Utils
 {
@@ -20,7 +36,8 @@ namespace Core::Utils
         BUTTON_CLICK, // New
         SELECT_CLICK, // Newer
         TRACKER_UPDATE,
-        CHECK_USER_MATCH
+        CHECK_USER_MATCH,
+        COROUTINE_RESUME
     };
 
     // Abstract Task
@@ -32,6 +49,119 @@ namespace Core::Utils
 
         TaskPriority priority = TaskPriority::Standard;
         TaskType type = TaskType::GENERIC;
+
+        // Stamped by TaskManager::submit; used for queue wait accounting
+        std::chrono::steady_clock::time_point enqueued_at;
+
+        // When the triggering event reached us (interactions); the deadline is counted from here
+        std::chrono::steady_clock::time_point arrived_at;
+
+        // When the work must have started by (e.g. Discord's interaction window). High tasks are
+        // dispatched earliest deadline first; tasks without one keep FIFO order behind those that have one.
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    };
+
+    // Dispatch order of the High queue: earliest deadline first, then arrival
+    struct EarliestDeadlineFirst
+    {
+        bool operator()(const std::unique_ptr<Task> &a, const std::unique_ptr<Task> &b) const
+        {
+            if (a->deadline != b->deadline)
+                return a->deadline < b->deadline;
+            return a->enqueued_at < b->enqueued_at;
+        }
+    };
+
+    // ---------------------------------------------------------
+    // Coroutine Tasks
+    // ---------------------------------------------------------
+    // A Task can hand its work to a coroutine that co_awaits asynchronous operations (Riot requests,
+    // which also covers waiting for rate-limit slots). While suspended it holds no worker; each
+    // resumption is queued as a TaskResume at the coroutine's priority, so thousands of checks can be
+    // in flight on a handful of threads.
+
+    // Return type of a coroutine task. Lazily started: nothing runs until Start().
+    class CoTask
+    {
+    public:
+        struct promise_type
+        {
+            std::shared_ptr<AppContext> ctx; // Where resumptions are submitted
+            TaskPriority priority = TaskPriority::Standard;
+
+            CoTask get_return_object() { return CoTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; } // The frame frees itself when the body ends
+            void return_void() {}
+            void unhandled_exception();
+        };
+        using Handle = std::coroutine_handle<promise_type>;
+
+        CoTask(CoTask &&other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+        CoTask(const CoTask &) = delete;
+        CoTask &operator=(const CoTask &) = delete;
+        ~CoTask();
+
+        // Runs the coroutine on the calling thread until its first suspension. From then on the frame is
+        // owned by whatever will resume it (a pending callback or a queued TaskResume).
+        void Start(std::shared_ptr<AppContext> ctx, TaskPriority priority);
+
+    private:
+        explicit CoTask(Handle handle) : m_handle(handle) {}
+        Handle m_handle;
+    };
+
+    // Queues a suspended coroutine to continue on a worker at its priority.
+    void ResumeOnPool(CoTask::Handle handle);
+
+    // co_await Async<T>(start): `start` receives a completion callback and begins an asynchronous
+    // operation, e.g. a RiotClient *Async call. The worker is released until the callback fires (on any
+    // thread); the coroutine then continues on a worker with the result. If the callback fires before
+    // the coroutine finished suspending (cache hit), it simply carries on without a round trip.
+    template <typename T> class Async
+    {
+    public:
+        using Starter = std::function<void(std::function<void(T)>)>;
+
+        explicit Async(Starter start) : m_start(std::move(start)) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(CoTask::Handle handle)
+        {
+            m_handle = handle;
+            m_start(
+                [this](T value)
+                {
+                    m_result = std::move(value);
+                    // Whichever side gets here second owns the resumption
+                    if (m_completed.exchange(true, std::memory_order_acq_rel))
+                        ResumeOnPool(m_handle);
+                });
+            return !m_completed.exchange(true, std::memory_order_acq_rel);
+        }
+
+        T await_resume() { return std::move(*m_result); }
+
+    private:
+        Starter m_start;
+        CoTask::Handle m_handle;
+        std::optional<T> m_result;
+        std::atomic<bool> m_completed{false};
+    };
+
+    // Resumes one coroutine step on a worker. Dropping it unrun (shutdown) destroys the frame,
+    // which releases everything the coroutine held through its destructors.
+    class TaskResume : public Task
+    {
+    public:
+        explicit TaskResume(CoTask::Handle handle);
+        ~TaskResume() override;
+
+        void process() override;
+
+    private:
+        CoTask::Handle m_handle;
     };
 
     // ---------------------------------------------------------
@@ -54,6 +184,7 @@ namespace Core::Utils
     public:
         dpp::button_click_t event;
         std::shared_ptr<AppContext> ctx;
+        std::shared_ptr<Core::Discord::ComponentResponse> response; // Shared with the ack watchdog
 
         void process() override;
     };
@@ -64,6 +195,7 @@ namespace Core::Utils
     public:
         dpp::select_click_t event;
         std::shared_ptr<AppContext> ctx;
+        std::shared_ptr<Core::Discord::ComponentResponse> response; // Shared with the ack watchdog
 
         void process() override;
     };
@@ -74,40 +206,264 @@ namespace Core::Utils
     {
     public:
         std::shared_ptr<AppContext> ctx;
+        TaskPriority checkPriority = TaskPriority::Low; // Priority of the spawned user checks
 
         void process() override;
     };
 
-    // 4. Individual User Match Check
-    // This task handles the API call and logic for a single user
+    // 4. In-flight deduplication for TaskCheckUserMatch
+    // Keeps at most one check per Riot account (riot_puuid, region) queued or running. Duplicate
+    // requests merge their Discord link into the pending check; a higher-priority duplicate re-queues
+    // it at the higher priority, and a duplicate arriving mid-run schedules exactly one re-run.
+    class UserCheckRegistry
+    {
+    public:
+        struct Ticket
+        {
+            std::string key;
+            std::vector<Server::DB::User> users; // Every Discord link merged into this check
+            TaskPriority priority = TaskPriority::Low;
+            bool running = false;
+            bool rerun = false;
+            bool done = false; // Set once the ticket leaves the registry; stale queued copies become no-ops
+        };
+
+        // Queues a check for one Riot account (`links` = every Discord user linked to it) or merges the
+        // links into the check already in flight. Returns false only if a new task was needed and the queue rejected it.
+        bool Schedule(const std::shared_ptr<AppContext> &ctx, const std::vector<Server::DB::User> &links, TaskPriority priority);
+
+        // Whether a check for the account ("puuid|region") is queued or running.
+        bool InFlight(const std::string &key);
+
+        // Called by the first queued copy to run. Returns false for copies made redundant by a sibling.
+        bool Claim(const std::shared_ptr<Ticket> &ticket);
+
+        // Snapshot of the Discord links to process for a claimed ticket.
+        std::vector<Server::DB::User> Users(const std::shared_ptr<Ticket> &ticket);
+
+        // Releases a claimed ticket, re-queuing it once if a duplicate arrived while it ran.
+        void Finish(const std::shared_ptr<AppContext> &ctx, const std::shared_ptr<Ticket> &ticket);
+
+    private:
+        bool SubmitCopy(const std::shared_ptr<AppContext> &ctx, const std::shared_ptr<Ticket> &ticket, TaskPriority priority);
+        void Drop(const std::shared_ptr<Ticket> &ticket);
+
+        std::mutex m_mutex;
+        std::unordered_map<std::string, std::shared_ptr<Ticket>> m_tickets;
+    };
+
+    // 5. Individual User Match Check
+    // This task handles the API calls and logic for one Riot account (all Discord links to it)
     class TaskCheckUserMatch : public Task
     {
     public:
+        ~TaskCheckUserMatch() override;
+
         std::shared_ptr<AppContext> ctx;
-        Server::DB::User user;
+        std::shared_ptr<UserCheckRegistry::Ticket> ticket;
 
         void process() override;
+
+    private:
+        // The check itself. Runs as a coroutine so the worker is free while Riot requests are in flight;
+        // the frame owns the claimed ticket and releases it when the check ends.
+        static CoTask CheckAccount(std::shared_ptr<AppContext> ctx, std::shared_ptr<UserCheckRegistry::Ticket> ticket);
+
+        // A new match analysed during the poll, and the links it still has to be recorded for
+        struct AnalyzedMatch
+        {
+            std::string match_id;
+            Server::Riot::MatchStats stats;
+            std::vector<Server::DB::User> pending;
+        };
+        using Notifications = std::vector<std::pair<int64_t, std::string>>; // Discord ID, DM text
+
+        // Records the poll's matches and advances the cursors in one transaction; nullopt if it rolled back
+        static std::optional<Notifications> RecordPoll(Server::DB::Database &db, const std::vector<Server::DB::User> &links,
+                                                       const std::vector<AnalyzedMatch> &analyzed,
+                                                       const Core::Tracker::PollProgress &progress);
+
+        // Stores the poll (through the write-behind queue when there is one) and then sends the DMs.
+        // `hold` is released once the writes have ended.
+        static void PersistPoll(AppContext &ctx, const std::vector<Server::DB::User> &links, std::vector<AnalyzedMatch> analyzed,
+                                const Core::Tracker::PollProgress &progress, std::shared_ptr<void> hold);
+
+        bool m_started = false; // The coroutine took over the pendingUserChecks slot
     };
 
     // ---------------------------------------------------------
     // Task Manager (Worker Pool)
     // ---------------------------------------------------------
+    enum class SchedulerMode
+    {
+        Shared,      // Three global priority queues shared by every worker
+        WorkStealing // Per-worker deques; Standard/Low tasks submitted from a worker stay local, idle workers steal. Experimental.
+    };
+
+    // Parses the "thread_pool_scheduler" config value ("shared" / "work_stealing"). Unknown values fall back to Shared.
+    SchedulerMode ParseSchedulerMode(const std::string &name);
+
+    struct TaskManagerOptions
+    {
+        size_t num_threads = 4;
+        SchedulerMode scheduler = SchedulerMode::Shared;
+
+        // Dequeue shares per class, indexed by TaskPriority (Low, Standard, High).
+        // When several classes are backlogged each one gets weight/sum of the dispatch slots.
+        std::array<unsigned, 3> weights = {1, 3, 8};
+
+        // A backlogged class that has not been served for this long jumps the queue once.
+        // Bounds how long Low (tracker) work can wait behind steady interactive traffic.
+        std::chrono::milliseconds aging_threshold{30000};
+
+        // How often per-class queue wait statistics are logged (0 disables).
+        std::chrono::seconds stats_interval{300};
+
+        // Maximum queued tasks per class, indexed by TaskPriority (0 = unbounded). Enforced by try_submit.
+        std::array<size_t, 3> capacity = {20000, 1000, 1000};
+    };
+
+    // Queue wait statistics for one priority class over the current reporting window.
+    struct QueueClassStats
+    {
+        uint64_t dispatched = 0;
+        size_t queued = 0;
+        double avg_wait_ms = 0.0;
+        double p50_wait_ms = 0.0; // Histogram bucket upper bounds (power-of-two microseconds)
+        double p99_wait_ms = 0.0;
+        double max_wait_ms = 0.0;
+        size_t high_water = 0;  // Deepest queue seen in the window
+        uint64_t rejected = 0;  // try_submit calls refused because the class was full
+    };
+
     class TaskManager
     {
     public:
-        TaskManager(size_t num_threads, std::shared_ptr<AppContext> context);
+        TaskManager(const TaskManagerOptions &options, std::shared_ptr<AppContext> context);
         ~TaskManager();
 
+        // Always enqueues, ignoring capacity. Reserved for work that must not be dropped.
         void submit(std::unique_ptr<Task> task);
 
+        // Enqueues only if the task's class is below capacity. On rejection returns false and
+        // leaves the task with the caller, so it can report "busy" or retry on the next sweep.
+        bool try_submit(std::unique_ptr<Task> &task);
+
+        // Snapshot of the current window's queue wait statistics, indexed by TaskPriority.
+        std::array<QueueClassStats, 3> GetQueueStats() const;
+
+        // Delayed and recurring work. Timers live in one min-heap served by a single timer thread, so a
+        // pending timer holds no worker; due tasks go through submit(). Returns an id for cancel_timer.
+        using TimerId = uint64_t;
+        using Clock = std::chrono::steady_clock;
+        using TaskFactory = std::function<std::unique_ptr<Task>()>;
+
+        TimerId submit_at(Clock::time_point when, std::unique_ptr<Task> task);
+        TimerId submit_after(Clock::duration delay, std::unique_ptr<Task> task);
+
+        // Submits a fresh task from `factory` every `period`, the first one after `initial_delay`.
+        // Occurrences go through try_submit: one that finds its class full is skipped, not queued up,
+        // and a late timer thread never fires a backlog of missed occurrences. A null task skips one too.
+        TimerId submit_every(Clock::duration period, TaskFactory factory, Clock::duration initial_delay = Clock::duration::zero());
+
+        // Runs `fn` on the timer thread itself at `when`, for tiny non-blocking work that must not wait
+        // for a free worker (e.g. acknowledging a Discord interaction before its window closes).
+        TimerId run_at(Clock::time_point when, std::function<void()> fn);
+
+        // Cancels a pending timer; returns false if it already fired (one-shot) or does not exist.
+        bool cancel_timer(TimerId id);
+
+        size_t pending_timers() const;
+
     private:
-        void WorkerLoop();
+        // Per-worker deques used by SchedulerMode::WorkStealing, one per priority class.
+        // The owner pushes/pops at the back (LIFO keeps fan-out work cache-warm), thieves take from the front.
+        struct WorkerDeque
+        {
+            std::mutex mutex;
+            std::array<std::deque<std::unique_ptr<Task>>, 3> tasks;
+        };
+
+        // Lock-free log2 histogram of queue wait times for one class
+        struct WaitHistogram
+        {
+            static constexpr size_t BUCKETS = 32; // bucket i holds waits in [2^i, 2^(i+1)) microseconds
+            std::array<std::atomic<uint64_t>, BUCKETS> buckets{};
+            std::atomic<uint64_t> count{0};
+            std::atomic<uint64_t> total_us{0};
+            std::atomic<uint64_t> max_us{0};
+        };
+
+        struct Timer
+        {
+            std::unique_ptr<Task> task;     // One-shot
+            std::function<void()> callback; // One-shot, run on the timer thread
+            TaskFactory factory;            // Recurring
+            Clock::duration period{0};
+        };
+
+        // Heap entry; the Timer itself stays in m_timers so cancel is a map erase (the entry goes stale)
+        struct TimerSlot
+        {
+            Clock::time_point when;
+            TimerId id;
+            bool operator>(const TimerSlot &other) const { return when != other.when ? when > other.when : id > other.id; }
+        };
+
+        TimerId AddTimer(Clock::time_point when, Timer timer);
+        void TimerLoop();
+
+        void Enqueue(std::unique_ptr<Task> task);
+        void NoteDepth(size_t cls, size_t depth);
+        void WorkerLoop(size_t index);
         bool TryPopWeighted(std::unique_ptr<Task> &task);
+        std::array<TaskPriority, 3> PickOrder();
+        void RecordDispatch(const Task &task);
+        void MaybeLogQueueStats();
+        bool TryPopClass(TaskPriority priority, std::unique_ptr<Task> &task);
+        bool PopLocal(TaskPriority priority, std::unique_ptr<Task> &task);
+        bool Steal(TaskPriority priority, std::unique_ptr<Task> &task);
+        void PushGlobal(std::unique_ptr<Task> task);
+        bool PopGlobal(TaskPriority priority, std::unique_ptr<Task> &task);
+
+        TaskManagerOptions m_options;
 
-        ThreadsafeQueue<std::unique_ptr<Task>> m_highQueue;
+        ThreadsafePriorityQueue<std::unique_ptr<Task>, EarliestDeadlineFirst> m_highQueue;
         ThreadsafeQueue<std::unique_ptr<Task>> m_stdQueue;
         ThreadsafeQueue<std::unique_ptr<Task>> m_lowQueue;
 
+        // Work-stealing state. The global queues above double as the injection queues for
+        // tasks submitted from outside the pool (Discord events, timers).
+        std::vector<std::unique_ptr<WorkerDeque>> m_local;
+        std::array<std::atomic<size_t>, 3> m_localCount{};
+
+        // Weighted/aging scheduling state. m_queued counts every queued task per class (global + local);
+        // m_servedAt is the steady_clock tick a class last made progress (or became backlogged).
+        std::array<std::atomic<size_t>, 3> m_queued{};
+        std::array<std::atomic<int64_t>, 3> m_servedAt{};
+        std::array<int64_t, 3> m_credit{}; // smooth weighted round-robin credits, guarded by m_schedMutex
+        std::mutex m_schedMutex;
+
+        std::array<WaitHistogram, 3> m_waits;
+
+        // Backpressure bookkeeping: window high-water mark, last logged mark and rejections per class
+        std::array<std::atomic<size_t>, 3> m_highWater{};
+        std::array<std::atomic<size_t>, 3> m_loggedHighWater{};
+        std::array<std::atomic<uint64_t>, 3> m_rejected{};
+        std::atomic<int64_t> m_nextStatsLog{0};
+
+        // Shared by all three queues so idle workers sleep until any priority receives work
+        QueueSignal m_signal;
+
+        // Timer state, guarded by m_timerMutex
+        mutable std::mutex m_timerMutex;
+        std::condition_variable m_timerCv;
+        std::priority_queue<TimerSlot, std::vector<TimerSlot>, std::greater<TimerSlot>> m_timerHeap;
+        std::unordered_map<TimerId, Timer> m_timers;
+        TimerId m_nextTimerId = 1;
+        bool m_timersStopped = false;
+        std::thread m_timerThread;
+
         std::atomic<bool> m_done;
         std::vector<std::thread> m_workers;
         std::shared_ptr<AppContext> m_ctx;
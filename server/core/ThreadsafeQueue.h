@@ -1,26 +1,141 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <mutex>
 #include <queue>
+#include <vector>
 
 namespace Core::Utils
 {
+    /// @brief Wakeup channel shared by several queues.
+    /// Lets a consumer sleep until *any* of the attached queues receives an element.
+    /// Consumers announce themselves with prepare_wait(), poll their queues one last time and
+    /// then wait for the epoch to change, so a push that lands between the poll and the wait is
+    /// never lost. Producers skip the mutex entirely while nobody is waiting.
+    class QueueSignal
+    {
+    public:
+        /// @brief Registers the caller as a waiter and returns the current epoch.
+        /// The caller must re-poll its queues after this and then call either wait() or cancel_wait().
+        uint64_t prepare_wait()
+        {
+            m_waiters.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_epoch;
+        }
+
+        /// @brief Deregisters a waiter whose final poll found work.
+        void cancel_wait() { m_waiters.fetch_sub(1); }
+
+        /// @brief Advances the epoch and wakes one waiting consumer, if any.
+        /// Call after the element is visible in its queue.
+        void notify_one()
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_waiters.load() == 0)
+                return;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ++m_epoch;
+            }
+            m_cond.notify_one();
+        }
+
+        /// @brief Advances the epoch and wakes every waiting consumer (used for shutdown).
+        void notify_all()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ++m_epoch;
+            }
+            m_cond.notify_all();
+        }
+
+        /// @brief Blocks until the epoch differs from `seen` or `stop()` returns true, then deregisters.
+        /// @param seen Epoch returned by prepare_wait().
+        /// @param stop Predicate checked under the lock (e.g. a shutdown flag).
+        template <typename Pred> void wait(uint64_t seen, Pred stop)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cond.wait(lock, [&] { return m_epoch != seen || stop(); });
+            }
+            m_waiters.fetch_sub(1);
+        }
+
+    private:
+        mutable std::mutex m_mutex;
+        std::condition_variable m_cond;
+        uint64_t m_epoch = 0;
+        std::atomic<size_t> m_waiters{0};
+    };
+
     template <typename T> class ThreadsafeQueue
     {
     public:
-        /// @brief Default Constructor
+        /// @brief Default Constructor (unbounded)
         ThreadsafeQueue() = default;
 
+        /// @brief Bounded queue. try_push() fails and push_wait() blocks while `capacity` elements are queued.
+        /// @param capacity Maximum number of queued elements (0 = unbounded).
+        explicit ThreadsafeQueue(size_t capacity) : m_capacity(capacity) {}
+
+        /// @brief Attaches a shared signal that is notified on every push.
+        /// Must be called before the queue is used concurrently.
+        /// @param signal Signal shared with the other queues a consumer waits on.
+        void attach(QueueSignal *signal) { m_signal = signal; }
+
         /// @brief Pushes a new element to the back of the queue
         /// This operation is thread-safe. It locks the queue, adds the element,
         /// and then notifies one waiting thread that a new element is available.
         /// @param value The element to be added to the queue
         void push(T value)
         {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            m_queue.push(std::move(value));
-            m_cond.notify_one();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_queue.push(std::move(value));
+                m_cond.notify_one();
+            }
+            if (m_signal)
+                m_signal->notify_one();
+        }
+
+        /// @brief Pushes only if the queue is below capacity and not closed.
+        /// @param value The element to add; left untouched when the push is refused.
+        /// @return true if the element was queued.
+        bool try_push(T &value)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_closed || Full())
+                    return false;
+                m_queue.push(std::move(value));
+                m_cond.notify_one();
+            }
+            if (m_signal)
+                m_signal->notify_one();
+            return true;
+        }
+
+        /// @brief Pushes, blocking while the queue is at capacity (backpressure on the producer).
+        /// @return false if the queue was closed before there was room; the element is dropped.
+        bool push_wait(T value)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_notFull.wait(lock, [this] { return m_closed || !Full(); });
+                if (m_closed)
+                    return false;
+                m_queue.push(std::move(value));
+                m_cond.notify_one();
+            }
+            if (m_signal)
+                m_signal->notify_one();
+            return true;
         }
 
         /// @brief Tries to pop an element from the queue without blocking.
@@ -35,9 +150,36 @@ namespace Core::Utils
             }
             value = std::move(m_queue.front());
             m_queue.pop();
+            m_notFull.notify_one();
+            return true;
+        }
+
+        /// @brief Pops an element, blocking while the queue is empty.
+        /// @param[out] value Reference to store the popped element.
+        /// @return false once the queue is closed (remaining elements are left for the destructor).
+        bool wait_pop(T &value)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this] { return m_closed || !m_queue.empty(); });
+            if (m_closed)
+                return false;
+            value = std::move(m_queue.front());
+            m_queue.pop();
+            m_notFull.notify_one();
             return true;
         }
 
+        /// @brief Wakes every blocked producer and consumer and refuses further pushes (used for shutdown).
+        void close()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_closed = true;
+            }
+            m_cond.notify_all();
+            m_notFull.notify_all();
+        }
+
         /// @brief Checks if the queue is empty.
         /// This operation is thread-safe
         /// @return true if the queue is empty, false otherwise
@@ -66,5 +208,70 @@ namespace Core::Utils
 
         /// @brief Condition variable to signal waiting threads.
         std::condition_variable m_cond;
+
+        /// @brief Signals producers blocked in push_wait() that room was made.
+        std::condition_variable m_notFull;
+
+        /// @brief Maximum number of elements (0 = unbounded) and the shutdown flag.
+        size_t m_capacity = 0;
+        bool m_closed = false;
+
+        bool Full() const { return m_capacity != 0 && m_queue.size() >= m_capacity; }
+
+        /// @brief Optional multi-queue signal (not owned).
+        QueueSignal *m_signal = nullptr;
+    };
+
+    /// @brief Thread-safe priority queue for a single consumer class.
+    /// try_pop() returns the element that orders first under `Before` (`Before(a, b)` is true when `a`
+    /// should come out ahead of `b`). Same push/attach contract as ThreadsafeQueue.
+    template <typename T, typename Before> class ThreadsafePriorityQueue
+    {
+    public:
+        /// @brief Attaches a shared signal that is notified on every push.
+        /// Must be called before the queue is used concurrently.
+        void attach(QueueSignal *signal) { m_signal = signal; }
+
+        /// @brief Inserts an element at its place in the order.
+        void push(T value)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_heap.push_back(std::move(value));
+                std::push_heap(m_heap.begin(), m_heap.end(), After{});
+            }
+            if (m_signal)
+                m_signal->notify_one();
+        }
+
+        /// @brief Pops the first element in order without blocking.
+        /// @return false if the queue was empty.
+        bool try_pop(T &value)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_heap.empty())
+                return false;
+            std::pop_heap(m_heap.begin(), m_heap.end(), After{});
+            value = std::move(m_heap.back());
+            m_heap.pop_back();
+            return true;
+        }
+
+        size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_heap.size();
+        }
+
+    private:
+        // The std heap algorithms keep the *largest* element on top, so invert the order
+        struct After
+        {
+            bool operator()(const T &a, const T &b) const { return Before{}(b, a); }
+        };
+
+        std::vector<T> m_heap;
+        mutable std::mutex m_mutex;
+        QueueSignal *m_signal = nullptr;
     };
 } // namespace Core::Utils
\ No newline at end of file
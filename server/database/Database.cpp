@@ -1,6 +1,8 @@
 #include "server/database/Database.h"
+#include "server/database/ExerciseCatalog.h"
+#include "server/database/HotQueries.h"
+#include "server/database/LeaderboardIndex.h"
 #include <algorithm>
-#include <random>
 #include <stdexcept>
 
 namespace Server::DB
@@ -12,16 +14,73 @@ namespace Server::DB
         return txt ? std::string(txt) : "";
     }
 
-    Database::Database(const std::string &dbPath)
+    Database::Database(const std::string &dbPath, size_t readConnections) : m_leaderboards(std::make_unique<LeaderboardIndex>())
     {
         if (sqlite3_open(dbPath.c_str(), &m_db) != SQLITE_OK)
         {
             throw std::runtime_error("Failed to open database");
         }
+        m_statements.Attach(m_db);
         Initialize();
+        LoadExerciseCatalog({});
+        LoadLeaderboards();
+
+        // Opened after Initialize so the schema they see exists. Private in-memory databases are per
+        // connection, so they keep reading through the writer.
+        bool inMemory = dbPath.empty() || dbPath == ":memory:" || dbPath.rfind("file::memory:", 0) == 0;
+        if (!inMemory)
+            OpenReaders(dbPath, readConnections);
     }
 
-    Database::~Database() { sqlite3_close(m_db); }
+    Database::~Database()
+    {
+        // sqlite3_close refuses while statements are still prepared
+        for (auto &reader : m_readers)
+        {
+            reader->statements.Clear();
+            sqlite3_close(reader->db);
+        }
+        m_statements.Clear();
+        sqlite3_close(m_db);
+    }
+
+    void Database::OpenReaders(const std::string &dbPath, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto reader = std::make_unique<ReadConnection>();
+            if (sqlite3_open_v2(dbPath.c_str(), &reader->db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK)
+            {
+                std::cerr << "SQL Error: failed to open read connection (" << sqlite3_errmsg(reader->db)
+                          << "), reading through the writer" << std::endl;
+                sqlite3_close(reader->db);
+                break;
+            }
+            // WAL readers only wait while the log is being recovered or checkpointed in truncate mode
+            sqlite3_busy_timeout(reader->db, 5000);
+            reader->statements.Attach(reader->db);
+            m_idleReaders.push_back(reader.get());
+            m_readers.push_back(std::move(reader));
+        }
+    }
+
+    Database::ReaderLease Database::AcquireReader()
+    {
+        std::unique_lock<std::mutex> lock(m_readerMutex);
+        m_readerAvailable.wait(lock, [this] { return !m_idleReaders.empty(); });
+        ReadConnection *conn = m_idleReaders.back();
+        m_idleReaders.pop_back();
+        return ReaderLease(*this, conn);
+    }
+
+    void Database::ReleaseReader(ReadConnection *conn)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_readerMutex);
+            m_idleReaders.push_back(conn);
+        }
+        m_readerAvailable.notify_one();
+    }
 
     void Database::ExecuteSQL(const std::string &sql)
     {
@@ -34,14 +93,94 @@ namespace Server::DB
         }
     }
 
+    Database::Transaction::Transaction(Database &db) : m_db(db), m_lock(db.m_mutex), m_depth(++db.m_txDepth),
+                                                      m_boardMark(db.m_boardPending.size())
+    {
+        // A statement failing from here on only fails this level; the outer flag comes back when it ends
+        m_outerFailed = m_db.m_txFailed;
+        m_db.m_txFailed = false;
+
+        // IMMEDIATE takes the write lock up front; there is only one writer connection, so it never waits
+        std::string begin = m_depth == 1 ? "BEGIN IMMEDIATE" : "SAVEPOINT tx" + std::to_string(m_depth);
+        if (sqlite3_exec(m_db.m_db, begin.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK)
+        {
+            std::cerr << "SQL Error (" << begin << "): " << sqlite3_errmsg(m_db.m_db) << std::endl;
+            m_db.m_txFailed = true;
+        }
+        if (m_depth == 1)
+            m_db.m_txOwner.store(std::this_thread::get_id(), std::memory_order_relaxed);
+    }
+
+    Database::Transaction::~Transaction()
+    {
+        if (m_open)
+            m_db.EndTransaction(m_depth, false, m_outerFailed, m_boardMark); // Abandoned (early return or exception)
+    }
+
+    bool Database::Transaction::Commit()
+    {
+        if (!m_open)
+            return false;
+        m_open = false;
+        return m_db.EndTransaction(m_depth, true, m_outerFailed, m_boardMark);
+    }
+
+    bool Database::EndTransaction(int depth, bool commit, bool outerFailed, size_t boardMark)
+    {
+        // Caller holds m_mutex through its Transaction
+        bool kept = commit && !m_txFailed;
+        m_txDepth = depth - 1;
+        m_txFailed = outerFailed;
+
+        if (depth > 1)
+        {
+            std::string name = "tx" + std::to_string(depth);
+            if (!kept)
+            {
+                sqlite3_exec(m_db, ("ROLLBACK TO " + name).c_str(), nullptr, nullptr, nullptr);
+                m_boardPending.resize(boardMark);
+            }
+            sqlite3_exec(m_db, ("RELEASE " + name).c_str(), nullptr, nullptr, nullptr);
+            return kept;
+        }
+
+        m_txOwner.store(std::thread::id(), std::memory_order_relaxed);
+        auto staged = std::move(m_boardPending);
+        m_boardPending.clear();
+        if (kept)
+        {
+            if (sqlite3_exec(m_db, "COMMIT", nullptr, nullptr, nullptr) == SQLITE_OK)
+            {
+                for (auto &change : staged)
+                    change(*m_leaderboards);
+                return true;
+            }
+            std::cerr << "SQL Error (Commit): " << sqlite3_errmsg(m_db) << std::endl;
+            kept = false;
+        }
+        if (!sqlite3_get_autocommit(m_db))
+            sqlite3_exec(m_db, "ROLLBACK", nullptr, nullptr, nullptr);
+        return kept;
+    }
+
+    void Database::StageLeaderboard(std::function<void(LeaderboardIndex &)> change)
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        if (m_txDepth > 0)
+            m_boardPending.push_back(std::move(change));
+        else
+            change(*m_leaderboards);
+    }
+
     void Database::Initialize()
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
 
         // Enable Write-Ahead Logging (WAL) for better concurrency
         ExecuteSQL("PRAGMA journal_mode=WAL;");
         ExecuteSQL("PRAGMA synchronous=NORMAL;");
 
+        // Version-0 tables; everything added since comes from the numbered migrations below
         const char *schema = R"(
             CREATE TABLE IF NOT EXISTS users (
                 discord_id INTEGER,
@@ -50,9 +189,6 @@ namespace Server::DB
                 riot_tag TEXT,
                 region TEXT,
                 last_match_id TEXT,
-                wimp_mult_upper REAL DEFAULT 1.0,
-                wimp_mult_lower REAL DEFAULT 1.0,
-                wimp_mult_core REAL DEFAULT 1.0,
                 PRIMARY KEY (discord_id, riot_puuid)
             );
             
@@ -74,7 +210,6 @@ namespace Server::DB
                 kp_percent REAL,
                 cs_total INTEGER,
                 cs_min REAL,
-                game_duration INTEGER DEFAULT 0,
                 PRIMARY KEY (match_id, user_id)
             );
             CREATE TABLE IF NOT EXISTS exercise_queue (
@@ -96,16 +231,157 @@ namespace Server::DB
         )";
         ExecuteSQL(schema);
 
-        auto safeExec = [&](const char *sql) {
-            char *errMsg = 0;
-            sqlite3_exec(m_db, sql, 0, 0, &errMsg);
-            if (errMsg) sqlite3_free(errMsg);
+        Migrate();
+    }
+
+    // =========================== MIGRATIONS ===========================
+
+    namespace
+    {
+        bool ExecMigrationSQL(sqlite3 *db, const std::string &sql)
+        {
+            char *errMsg = nullptr;
+            if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg) == SQLITE_OK)
+                return true;
+            std::cerr << "SQL Error (Migration): " << (errMsg ? errMsg : sqlite3_errmsg(db)) << "\nSQL: " << sql << std::endl;
+            sqlite3_free(errMsg);
+            return false;
+        }
+
+        // Databases from before versioned migrations got these columns from ALTERs re-run on every start,
+        // so any of them may or may not be there already
+        bool AddColumnIfMissing(sqlite3 *db, const std::string &table, const std::string &column, const std::string &decl)
+        {
+            sqlite3_stmt *stmt = nullptr;
+            if (sqlite3_prepare_v2(db, ("SELECT 1 FROM pragma_table_info('" + table + "') WHERE name = ?").c_str(), -1, &stmt,
+                                   nullptr) != SQLITE_OK)
+                return false;
+            sqlite3_bind_text(stmt, 1, column.c_str(), -1, SQLITE_TRANSIENT);
+            bool exists = sqlite3_step(stmt) == SQLITE_ROW;
+            sqlite3_finalize(stmt);
+            return exists || ExecMigrationSQL(db, "ALTER TABLE " + table + " ADD COLUMN " + column + " " + decl);
+        }
+
+        // Recomputes the per-user summary tables (migration 3) from the raw tables
+        const char *REBUILD_USER_STATS_SQL = R"(
+            DELETE FROM user_stats;
+            DELETE FROM user_champion_deaths;
+            DELETE FROM user_exercise_totals;
+
+            INSERT INTO user_stats (user_id, total_games, total_deaths, max_deaths, total_duration, lowest_kda)
+                SELECT user_id, COUNT(*), SUM(deaths), MAX(deaths), SUM(COALESCE(game_duration, 0)),
+                       MIN(CASE WHEN deaths > 0 THEN CAST((kills + assists) AS REAL) / deaths END)
+                FROM games GROUP BY user_id;
+            INSERT INTO user_stats (user_id, pending_penance)
+                SELECT user_id, COUNT(*) FROM exercise_queue WHERE true GROUP BY user_id
+                ON CONFLICT (user_id) DO UPDATE SET pending_penance = excluded.pending_penance;
+
+            INSERT INTO user_champion_deaths (user_id, champion_name, deaths)
+                SELECT user_id, champion_name, SUM(deaths) FROM games GROUP BY user_id, champion_name;
+            INSERT INTO user_exercise_totals (user_id, exercise_name, reps)
+                SELECT user_id, exercise_name, SUM(reps) FROM exercise_history GROUP BY user_id, exercise_name;
+        )";
+
+        // Recomputes the leaderboard totals migration 4 added to user_stats (run after the rebuild above)
+        const char *REBUILD_KILLS_ASSISTS_SQL =
+            "UPDATE user_stats SET total_kills_assists = "
+            "COALESCE((SELECT SUM(kills + assists) FROM games g WHERE g.user_id = user_stats.user_id), 0)";
+
+        struct Migration
+        {
+            int version;
+            const char *description;
+            bool (*apply)(sqlite3 *db);
+        };
+
+        // Applied in order, each exactly once; PRAGMA user_version holds the last one applied. Append new
+        // migrations at the end and never change one that has shipped; the CREATE TABLEs in Initialize stay
+        // at version 0.
+        const Migration MIGRATIONS[] = {
+            {1, "per-muscle-group multipliers, game duration, poll cursor",
+             [](sqlite3 *db) {
+                 return AddColumnIfMissing(db, "users", "wimp_mult_upper", "REAL DEFAULT 1.0") &&
+                        AddColumnIfMissing(db, "users", "wimp_mult_lower", "REAL DEFAULT 1.0") &&
+                        AddColumnIfMissing(db, "users", "wimp_mult_core", "REAL DEFAULT 1.0") &&
+                        AddColumnIfMissing(db, "games", "game_duration", "INTEGER DEFAULT 0") &&
+                        AddColumnIfMissing(db, "users", "last_match_time", "INTEGER DEFAULT 0");
+             }},
+            {2, "secondary indexes for per-user lookups",
+             [](sqlite3 *db) {
+                 // (user_id, match_id) also serves the plain user_id filters on the queue
+                 return ExecMigrationSQL(db, "CREATE INDEX IF NOT EXISTS idx_exercise_queue_user_match ON exercise_queue (user_id, match_id)") &&
+                        ExecMigrationSQL(db, "CREATE INDEX IF NOT EXISTS idx_exercise_history_user ON exercise_history (user_id, exercise_name)") &&
+                        ExecMigrationSQL(db, "CREATE INDEX IF NOT EXISTS idx_games_user_time ON games (user_id, timestamp)");
+             }},
+            {3, "per-user stats summary tables",
+             [](sqlite3 *db) {
+                 const char *tables = R"(
+                     CREATE TABLE IF NOT EXISTS user_stats (
+                         user_id INTEGER PRIMARY KEY,
+                         total_games INTEGER NOT NULL DEFAULT 0,
+                         total_deaths INTEGER NOT NULL DEFAULT 0,
+                         max_deaths INTEGER NOT NULL DEFAULT 0,
+                         total_duration INTEGER NOT NULL DEFAULT 0,
+                         lowest_kda REAL,
+                         pending_penance INTEGER NOT NULL DEFAULT 0
+                     );
+                     CREATE TABLE IF NOT EXISTS user_champion_deaths (
+                         user_id INTEGER,
+                         champion_name TEXT,
+                         deaths INTEGER NOT NULL DEFAULT 0,
+                         PRIMARY KEY (user_id, champion_name)
+                     ) WITHOUT ROWID;
+                     CREATE TABLE IF NOT EXISTS user_exercise_totals (
+                         user_id INTEGER,
+                         exercise_name TEXT,
+                         reps INTEGER NOT NULL DEFAULT 0,
+                         PRIMARY KEY (user_id, exercise_name)
+                     ) WITHOUT ROWID;
+                 )";
+                 return ExecMigrationSQL(db, tables) && ExecMigrationSQL(db, REBUILD_USER_STATS_SQL);
+             }},
+            {4, "leaderboard totals and guild membership",
+             [](sqlite3 *db) {
+                 const char *tables = R"(
+                     CREATE TABLE IF NOT EXISTS guild_members (
+                         guild_id INTEGER,
+                         user_id INTEGER,
+                         PRIMARY KEY (guild_id, user_id)
+                     ) WITHOUT ROWID;
+                 )";
+                 return AddColumnIfMissing(db, "user_stats", "total_kills_assists", "INTEGER NOT NULL DEFAULT 0") &&
+                        ExecMigrationSQL(db, REBUILD_KILLS_ASSISTS_SQL) && ExecMigrationSQL(db, tables);
+             }},
         };
+    } // namespace
 
-        safeExec("ALTER TABLE users ADD COLUMN wimp_mult_upper REAL DEFAULT 1.0");
-        safeExec("ALTER TABLE users ADD COLUMN wimp_mult_lower REAL DEFAULT 1.0");
-        safeExec("ALTER TABLE users ADD COLUMN wimp_mult_core REAL DEFAULT 1.0");
-        safeExec("ALTER TABLE games ADD COLUMN game_duration INTEGER DEFAULT 0");
+    void Database::Migrate()
+    {
+        // Caller holds m_mutex
+        int current = 0;
+        sqlite3_stmt *stmt = nullptr;
+        if (sqlite3_prepare_v2(m_db, "PRAGMA user_version", -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW)
+            current = sqlite3_column_int(stmt, 0);
+        sqlite3_finalize(stmt);
+
+        for (const auto &migration : MIGRATIONS)
+        {
+            if (migration.version <= current)
+                continue;
+
+            // The migration and its version bump commit together, so a crash can't half-apply one
+            std::cout << "[DB] Applying schema migration " << migration.version << ": " << migration.description << std::endl;
+            bool ok = ExecMigrationSQL(m_db, "BEGIN IMMEDIATE") && migration.apply(m_db) &&
+                      ExecMigrationSQL(m_db, "PRAGMA user_version = " + std::to_string(migration.version)) &&
+                      ExecMigrationSQL(m_db, "COMMIT");
+            if (!ok)
+            {
+                if (!sqlite3_get_autocommit(m_db))
+                    sqlite3_exec(m_db, "ROLLBACK", nullptr, nullptr, nullptr);
+                throw std::runtime_error("Schema migration " + std::to_string(migration.version) + " failed");
+            }
+            current = migration.version;
+        }
     }
 
     // =========================== USERS ===========================
@@ -114,13 +390,20 @@ namespace Server::DB
     {
         const char *sql =
             "INSERT OR REPLACE INTO users (discord_id, riot_puuid, riot_name, riot_tag, region, "
-            "last_match_id, wimp_mult_upper, wimp_mult_lower, wimp_mult_core) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)";
+            "last_match_id, wimp_mult_upper, wimp_mult_lower, wimp_mult_core, last_match_time) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
         
         std::optional<std::string> lastMatch;
         if (!user.last_match_id.empty()) lastMatch = user.last_match_id;
 
+        Transaction tx(*this);
         Execute(sql, user.discord_id, user.riot_puuid, user.riot_name, user.riot_tag, user.region, 
-                lastMatch, user.mult_upper, user.mult_lower, user.mult_core);
+                lastMatch, user.mult_upper, user.mult_lower, user.mult_core, user.last_match_time);
+
+        // Boards show one name per Discord user whatever the number of linked accounts; the same pick as LoadLeaderboards
+        auto name = QuerySingle<std::string>("SELECT MIN(riot_name) FROM users WHERE discord_id = ?",
+            [](sqlite3_stmt *stmt) { return ExtractText(stmt, 0); }, user.discord_id);
+        StageLeaderboard([id = user.discord_id, name = name.value_or("")](LeaderboardIndex &boards) { boards.SetName(id, name); });
+        tx.Commit();
     }
 
     std::vector<User> Database::GetDiscordUsers(int64_t discord_id)
@@ -136,9 +419,10 @@ namespace Server::DB
             u.mult_upper = sqlite3_column_double(stmt, 6);
             u.mult_lower = sqlite3_column_double(stmt, 7);
             u.mult_core = sqlite3_column_double(stmt, 8);
+            u.last_match_time = sqlite3_column_int64(stmt, 9);
             return u;
         };
-        return Query<User>("SELECT * FROM users WHERE discord_id = ?", mapper, discord_id);
+        return Query<User>(HotSql::GET_DISCORD_USERS, mapper, discord_id);
     }
 
     std::vector<User> Database::GetAllUsers()
@@ -154,14 +438,17 @@ namespace Server::DB
             u.mult_upper = sqlite3_column_double(stmt, 6);
             u.mult_lower = sqlite3_column_double(stmt, 7);
             u.mult_core = sqlite3_column_double(stmt, 8);
+            u.last_match_time = sqlite3_column_int64(stmt, 9);
             return u;
         };
         return Query<User>("SELECT * FROM users", mapper);
     }
 
-    void Database::UpdateLastMatch(int64_t discord_id, const std::string &puuid, const std::string &match_id)
+    void Database::UpdateLastMatch(int64_t discord_id, const std::string &puuid, const std::string &match_id, int64_t match_time)
     {
-        Execute("UPDATE users SET last_match_id = ? WHERE discord_id = ? AND riot_puuid = ?", match_id, discord_id, puuid);
+        // Only ever move the cursor forward, so a stale poll can't make the next one re-fetch old games
+        Execute(HotSql::UPDATE_LAST_MATCH,
+                match_id, match_time, discord_id, puuid, match_time);
     }
 
     void Database::SetUserMultiplier(int64_t discord_id, double multiplier, const std::string &type)
@@ -191,7 +478,7 @@ namespace Server::DB
         if (type == "lower") col = "wimp_mult_lower";
         else if (type == "core") col = "wimp_mult_core";
 
-        std::string sql = "SELECT " + col + " FROM users WHERE discord_id = ? LIMIT 1";
+        std::string sql = HotSql::UserMultiplier(col);
 
         auto res = QuerySingle<double>(sql, [](sqlite3_stmt* stmt){
             return sqlite3_column_double(stmt, 0);
@@ -202,21 +489,28 @@ namespace Server::DB
 
     // =========================== EXERCISES ===========================
 
-    void Database::SeedExercises(const std::vector<ExerciseDefinition> &exercises)
+    void Database::SeedExercises(const std::vector<ExerciseDefinition> &exercises, const std::map<std::string, double> &typeWeights)
     {
-        Execute("DELETE FROM exercises");
-        if (exercises.empty()) return;
-
-        for (const auto &ex : exercises)
         {
-            Execute("INSERT INTO exercises (exercise_name, set_count, exercise_type) VALUES (?, ?, ?)", 
-                    ex.name, ex.set_count, ex.type);
+            // One commit, and readers never see the table empty halfway through a reseed
+            Transaction tx(*this);
+            Execute("DELETE FROM exercises");
+
+            for (const auto &ex : exercises)
+            {
+                Execute("INSERT INTO exercises (exercise_name, set_count, exercise_type) VALUES (?, ?, ?)", 
+                        ex.name, ex.set_count, ex.type);
+            }
+            if (!tx.Commit())
+                return; // The table (and so the catalog) keeps the previous exercises
         }
+        // Reloaded rather than built from `exercises` so the snapshot carries the assigned IDs
+        LoadExerciseCatalog(typeWeights);
     }
 
-    std::vector<ExerciseDefinition> Database::GetAllExercises()
+    void Database::LoadExerciseCatalog(const std::map<std::string, double> &typeWeights)
     {
-         return Query<ExerciseDefinition>("SELECT id, exercise_name, set_count, exercise_type FROM exercises", 
+        auto exercises = Query<ExerciseDefinition>("SELECT id, exercise_name, set_count, exercise_type FROM exercises", 
             [](sqlite3_stmt* stmt){
                 ExerciseDefinition def;
                 def.id = sqlite3_column_int(stmt, 0);
@@ -225,33 +519,37 @@ namespace Server::DB
                 def.type = ExtractText(stmt, 3);
                 return def;
             });
+        m_catalog.store(std::make_shared<const ExerciseCatalog>(std::move(exercises), typeWeights));
+    }
+
+    std::vector<ExerciseDefinition> Database::GetAllExercises()
+    {
+        return m_catalog.load()->All();
     }
 
     std::optional<ExerciseDefinition> Database::GetRandomExercise()
     {
-        auto exs = GetAllExercises();
-        if (exs.empty())
-            return std::nullopt;
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
-        std::uniform_int_distribution<> dist(0, exs.size() - 1);
-        return exs[dist(gen)];
+        return m_catalog.load()->PickRandom();
     }
 
     // =========================== QUEUE ===========================
 
-    void Database::AddToQueue(int64_t user_id, const std::string &match_id, const std::string &exercise, int reps,
+    bool Database::AddToQueue(int64_t user_id, const std::string &match_id, const std::string &exercise, int reps,
                               int deaths)
     {
-        const char *sql =
-            "INSERT INTO exercise_queue (user_id, match_id, exercise_name, reps, original_deaths) VALUES (?, ?, ?, ?, ?)";
-        Execute(sql, user_id, match_id, exercise, reps, deaths);
+        const char *sql = HotSql::ADD_TO_QUEUE;
+        Transaction tx(*this);
+        if (Execute(sql, user_id, match_id, exercise, reps, deaths) > 0)
+        {
+            Execute(HotSql::ADD_TO_QUEUE_STATS,
+                    user_id);
+        }
+        return tx.Commit();
     }
 
     std::vector<ExerciseQueueItem> Database::GetPendingPenance(int64_t user_id)
     {
-        const char *sql = "SELECT id, user_id, match_id, exercise_name, reps, original_deaths, timestamp FROM "
-                          "exercise_queue WHERE user_id = ?";
+        const char *sql = HotSql::GET_PENDING_PENANCE;
         return Query<ExerciseQueueItem>(sql, [](sqlite3_stmt* stmt){
             ExerciseQueueItem item;
             item.id = sqlite3_column_int(stmt, 0);
@@ -268,15 +566,7 @@ namespace Server::DB
     // New Implementation for Rich Stats
     std::vector<PenanceDisplayInfo> Database::GetPendingPenanceDetailed(int64_t user_id)
     {
-        const char *sql = R"(
-            SELECT 
-                eq.id, eq.match_id, eq.exercise_name, eq.reps, eq.original_deaths,
-                g.champion_name, g.kills, g.deaths, g.assists, g.kp_percent, g.cs_total, g.cs_min, g.timestamp
-            FROM exercise_queue eq
-            LEFT JOIN games g ON eq.match_id = g.match_id AND eq.user_id = g.user_id
-            WHERE eq.user_id = ?
-            ORDER BY eq.id DESC
-        )";
+        const char *sql = HotSql::GET_PENDING_PENANCE_DETAILED;
 
         return Query<PenanceDisplayInfo>(sql, [](sqlite3_stmt* stmt){
             PenanceDisplayInfo item;
@@ -303,8 +593,7 @@ namespace Server::DB
 
     std::optional<ExerciseQueueItem> Database::GetPenanceByGameID(int64_t user_id, const std::string &match_id)
     {
-        const char *sql = "SELECT id, user_id, match_id, exercise_name, reps, original_deaths, timestamp FROM "
-                          "exercise_queue WHERE user_id = ? AND match_id = ? LIMIT 1";
+        const char *sql = HotSql::GET_PENANCE_BY_GAME_ID;
 
         return QuerySingle<ExerciseQueueItem>(sql, [](sqlite3_stmt* stmt){
              ExerciseQueueItem item;
@@ -321,98 +610,141 @@ namespace Server::DB
 
     void Database::CompletePenance(int64_t user_id, const std::string &match_id)
     {
+        // Atomic move from queue to history: a double click can't complete the same row twice
+        Transaction tx(*this);
         auto item = GetPenanceByGameID(user_id, match_id);
         if (!item) return;
 
-        Execute("DELETE FROM exercise_queue WHERE id = ?", item->id);
+        if (Execute(HotSql::COMPLETE_PENANCE_DELETE, item->id) == 0)
+            return; // Completed by someone else in the meantime
         Execute("INSERT INTO exercise_history (user_id, exercise_name, reps) VALUES (?, ?, ?)", 
                  user_id, item->exercise_name, item->reps);
+
+        Execute(HotSql::COMPLETE_PENANCE_STATS, user_id);
+        Execute("INSERT INTO user_exercise_totals (user_id, exercise_name, reps) VALUES (?, ?, ?) "
+                "ON CONFLICT (user_id, exercise_name) DO UPDATE SET reps = reps + excluded.reps",
+                user_id, item->exercise_name, item->reps);
+        StageLeaderboard([user_id, reps = item->reps](LeaderboardIndex &boards) { boards.Add(user_id, {.reps = reps}); });
+        tx.Commit();
     }
 
     void Database::UpdatePenance(int row_id, const std::string &new_ex, int new_reps)
     {
-        Execute("UPDATE exercise_queue SET exercise_name = ?, reps = ? WHERE id = ?", new_ex, new_reps, row_id);
+        Execute(HotSql::UPDATE_PENANCE, new_ex, new_reps, row_id);
     }
 
     // =========================== STATS ===========================
 
     bool Database::IsMatchProcessed(int64_t discord_id, const std::string &match_id)
     {
-        auto res = QuerySingle<int>("SELECT 1 FROM games WHERE match_id = ? AND user_id = ? LIMIT 1", 
+        auto res = QuerySingle<int>(HotSql::IS_MATCH_PROCESSED, 
             [](sqlite3_stmt*){ return 1; }, match_id, discord_id);
         return res.has_value();
     }
 
-    void Database::LogGame(int64_t user_id, const std::string &match_id, int64_t timestamp, int64_t gameDuration, const std::string &champ, int k,
+    std::optional<int64_t> Database::GetProcessedMatchEnd(int64_t discord_id, const std::string &match_id)
+    {
+        return QuerySingle<int64_t>(HotSql::GET_PROCESSED_MATCH_END,
+            [](sqlite3_stmt *stmt) { return static_cast<int64_t>(sqlite3_column_int64(stmt, 0)); }, match_id, discord_id);
+    }
+
+    bool Database::LogGame(int64_t user_id, const std::string &match_id, int64_t timestamp, int64_t gameDuration, const std::string &champ, int k,
                            int d, int a, double kp, int cs, double cs_min)
     {
-        const char *sql = "INSERT OR IGNORE INTO games (match_id, user_id, timestamp, champion_name, kills, deaths, "
-                          "assists, kp_percent, cs_total, cs_min, game_duration) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
-        Execute(sql, match_id, user_id, timestamp, champ, k, d, a, kp, cs, cs_min, gameDuration);
+        const char *sql = HotSql::LOG_GAME;
+        Transaction tx(*this);
+        if (Execute(sql, match_id, user_id, timestamp, champ, k, d, a, kp, cs, cs_min, gameDuration) == 0)
+            return tx.Commit(); // Already logged (the summaries count it already), unless the insert failed
+
+        // Games without deaths have no KDA ratio and leave the lowest one alone
+        std::optional<double> kda;
+        if (d > 0)
+            kda = static_cast<double>(k + a) / d;
+        Execute(HotSql::LOG_GAME_STATS,
+                user_id, d, d, gameDuration, kda, k + a);
+        Execute(HotSql::LOG_GAME_CHAMPION_DEATHS,
+                user_id, champ, d);
+        StageLeaderboard([user_id, d, ka = k + a](LeaderboardIndex &boards) {
+            boards.Add(user_id, {.games = 1, .deaths = d, .kills_assists = ka});
+        });
+        return tx.Commit();
     }
 
     UserStats Database::GetUserStats(int64_t user_id)
     {
         // NO LOCK here because Execute/Query take lock.
         // This relies on the fact that we don't need transactional consistency across all these separate selects for the UI view.
-        // (It's acceptable if data changes slightly between the death count query and the KDA query).
+        // Each one is a primary-key lookup on a summary table, bounded by the number of champions/exercises
+        // rather than the number of games.
         UserStats stats = {0, 0, 0.0, 0, 0.0, {}, {}, 0};
 
-        // 1. Basic Stats
-        auto basicStats = QuerySingle<std::tuple<int, int, int, double>>("SELECT SUM(deaths), COUNT(*), MAX(deaths), SUM(game_duration) FROM games WHERE user_id = ?",
+        // 1. Totals, lowest KDA and pending count
+        auto summary = QuerySingle<std::tuple<int, int, int, double, double, int>>(
+            HotSql::GET_USER_STATS_TOTALS,
             [](sqlite3_stmt* s){
                 return std::make_tuple(
                     sqlite3_column_int(s, 0),
                     sqlite3_column_int(s, 1),
                     sqlite3_column_int(s, 2),
-                    sqlite3_column_double(s, 3)
+                    sqlite3_column_double(s, 3),
+                    sqlite3_column_type(s, 4) != SQLITE_NULL ? sqlite3_column_double(s, 4) : 0.0,
+                    sqlite3_column_int(s, 5)
                 );
             }, user_id);
 
-        if (basicStats) {
-            auto [deaths, games, max_deaths, duration] = *basicStats;
+        if (summary) {
+            auto [deaths, games, max_deaths, duration, lowest_kda, pending] = *summary;
             stats.total_deaths = deaths;
             stats.total_games = games;
             stats.most_deaths_single = max_deaths;
             if (duration > 0) stats.avg_deaths_min = (double)deaths / (duration / 60.0);
+            stats.lowest_kda = lowest_kda;
+            stats.pending_penance_count = pending;
         }
 
-        // 2. KDA
-        auto kda = QuerySingle<double>("SELECT MIN(CAST((kills + assists) AS REAL) / NULLIF(deaths, 0)) FROM games WHERE user_id = ? AND deaths > 0",
-             [](sqlite3_stmt* s){
-                 if (sqlite3_column_type(s, 0) != SQLITE_NULL) return sqlite3_column_double(s, 0);
-                 return 0.0;
-             }, user_id);
-        if(kda) stats.lowest_kda = *kda;
-
-        // 3. Exercise Counts
-        auto exCounts = Query<std::pair<std::string, int>>("SELECT exercise_name, SUM(reps) FROM exercise_history WHERE user_id = ? GROUP BY exercise_name",
+        // 2. Exercise Counts
+        auto exCounts = Query<std::pair<std::string, int>>(HotSql::GET_USER_STATS_EXERCISES,
             [](sqlite3_stmt* s){
                 return std::make_pair(ExtractText(s, 0), sqlite3_column_int(s, 1));
             }, user_id);
         for(auto& p : exCounts) stats.exercise_counts[p.first] = p.second;
 
-        // 4. Top Death Champs
-        auto topChamps = Query<std::pair<std::string, int>>("SELECT champion_name, SUM(deaths) as d FROM games WHERE user_id = ? GROUP BY champion_name ORDER BY d DESC LIMIT 3",
+        // 3. Top Death Champs
+        stats.top_death_champs = Query<std::pair<std::string, int>>(
+            HotSql::GET_USER_STATS_CHAMPIONS,
              [](sqlite3_stmt* s){
                 return std::make_pair(ExtractText(s, 0), sqlite3_column_int(s, 1));
              }, user_id);
-        stats.top_death_champs = topChamps;
-
-        // 5. Pending Count
-        auto pending = QuerySingle<int>("SELECT COUNT(*) FROM exercise_queue WHERE user_id = ?", 
-            [](sqlite3_stmt* s){ return sqlite3_column_int(s, 0); }, user_id);
-        if(pending) stats.pending_penance_count = *pending;
 
         return stats;
     }
 
+    bool Database::RebuildUserStats()
+    {
+        {
+            Transaction tx(*this);
+            for (const char *sql : {REBUILD_USER_STATS_SQL, REBUILD_KILLS_ASSISTS_SQL})
+            {
+                char *errMsg = nullptr;
+                if (sqlite3_exec(m_db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK)
+                {
+                    std::cerr << "SQL Error (Rebuild stats): " << (errMsg ? errMsg : sqlite3_errmsg(m_db)) << std::endl;
+                    sqlite3_free(errMsg);
+                    return false; // Rolled back by tx
+                }
+            }
+            if (!tx.Commit())
+                return false;
+        }
+        LoadLeaderboards();
+        return true;
+    }
+
     // =========================== UI/UX IMPROVEMENTS ===========================
 
     std::vector<PenanceDisplayInfo> Database::GetRecentGames(int64_t user_id, int limit)
     {
-        const char *sql = "SELECT match_id, user_id, timestamp, champion_name, kills, deaths, assists, kp_percent, cs_total, "
-                          "cs_min FROM games WHERE user_id = ? ORDER BY timestamp DESC LIMIT ?";
+        const char *sql = HotSql::GET_RECENT_GAMES;
         
         return Query<PenanceDisplayInfo>(sql, [](sqlite3_stmt* stmt){
             PenanceDisplayInfo item;
@@ -429,34 +761,58 @@ namespace Server::DB
         }, user_id, limit);
     }
 
-    std::vector<std::pair<std::string, int>> Database::GetLeaderboard(const std::string &type)
+    LeaderboardPage Database::GetLeaderboard(const std::string &type, int64_t guild_id, size_t offset, size_t limit)
     {
-        std::string sql;
-        if (type == "reps")
-        {
-            sql = "SELECT u.riot_name, SUM(h.reps) as val FROM exercise_history h "
-                  "JOIN users u ON h.user_id = u.discord_id "
-                  "GROUP BY h.user_id ORDER BY val DESC LIMIT 10";
-        }
-        else if (type == "deaths")
-        {
-             sql = "SELECT u.riot_name, SUM(g.deaths) as val FROM games g "
-                  "JOIN users u ON g.user_id = u.discord_id "
-                  "GROUP BY g.user_id ORDER BY val DESC LIMIT 10";
-        }
-        else if (type == "kda")
+        auto category = LeaderboardIndex::ParseCategory(type);
+        if (!category)
+            return {};
+        return m_leaderboards->Page(*category, guild_id, offset, limit);
+    }
+
+    void Database::RecordGuildMember(int64_t guild_id, int64_t user_id)
+    {
+        if (guild_id == 0 || m_leaderboards->IsGuildMember(guild_id, user_id))
+            return; // Known already: no write on the command path
+
+        Transaction tx(*this);
+        Execute("INSERT OR IGNORE INTO guild_members (guild_id, user_id) VALUES (?, ?)", guild_id, user_id);
+        StageLeaderboard([guild_id, user_id](LeaderboardIndex &boards) { boards.AddGuildMember(guild_id, user_id); });
+        tx.Commit();
+    }
+
+    void Database::LoadLeaderboards()
+    {
+        // Held throughout so no write commits between these reads and the swap below
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        LeaderboardIndex fresh;
+
+        // One row per Discord user, however many Riot accounts they linked
+        const char *totalsSql = R"(
+            SELECT u.discord_id, u.name, COALESCE(s.total_games, 0), COALESCE(s.total_deaths, 0),
+                   COALESCE(s.total_kills_assists, 0), COALESCE(r.reps, 0)
+            FROM (SELECT discord_id, MIN(riot_name) AS name FROM users GROUP BY discord_id) u
+            LEFT JOIN user_stats s ON s.user_id = u.discord_id
+            LEFT JOIN (SELECT user_id, SUM(reps) AS reps FROM user_exercise_totals GROUP BY user_id) r ON r.user_id = u.discord_id
+        )";
+        auto totals = Query<std::tuple<int64_t, std::string, LeaderboardIndex::Totals>>(totalsSql, [](sqlite3_stmt *stmt) {
+            LeaderboardIndex::Totals t{.games = sqlite3_column_int64(stmt, 2),
+                                       .deaths = sqlite3_column_int64(stmt, 3),
+                                       .kills_assists = sqlite3_column_int64(stmt, 4),
+                                       .reps = sqlite3_column_int64(stmt, 5)};
+            return std::make_tuple(static_cast<int64_t>(sqlite3_column_int64(stmt, 0)), ExtractText(stmt, 1), t);
+        });
+        for (const auto &[id, name, t] : totals)
         {
-             sql = "SELECT u.riot_name, (CAST((SUM(g.kills) + SUM(g.assists)) AS REAL) / MAX(SUM(g.deaths), 1)) * 100 as val "
-                   "FROM games g "
-                   "JOIN users u ON g.user_id = u.discord_id "
-                   "GROUP BY g.user_id HAVING COUNT(*) > 5 ORDER BY val DESC LIMIT 10";
+            fresh.Add(id, t);
+            fresh.SetName(id, name);
         }
 
-        if (sql.empty()) return {};
-
-        return Query<std::pair<std::string, int>>(sql, [](sqlite3_stmt* stmt){
-            std::string name = ExtractText(stmt, 0);
-            return std::make_pair(name.empty() ? "Unknown" : name, sqlite3_column_int(stmt, 1));
+        auto members = Query<std::pair<int64_t, int64_t>>("SELECT guild_id, user_id FROM guild_members", [](sqlite3_stmt *stmt) {
+            return std::make_pair(static_cast<int64_t>(sqlite3_column_int64(stmt, 0)), static_cast<int64_t>(sqlite3_column_int64(stmt, 1)));
         });
+        for (const auto &[guild, user] : members)
+            fresh.AddGuildMember(guild, user);
+
+        m_leaderboards->Assign(std::move(fresh));
     }
 } // namespace Server::DB
\ No newline at end of file
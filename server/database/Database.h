@@ -1,15 +1,24 @@
 #pragma once
 
+#include "server/database/StatementCache.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <sqlite3.h>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace Server::DB
 {
+    class ExerciseCatalog;
+    class LeaderboardIndex;
+
     struct User
     {
         int64_t discord_id;
@@ -18,6 +27,7 @@ namespace Server::DB
         std::string riot_tag;
         std::string region;
         std::string last_match_id;
+        int64_t last_match_time = 0; // End of the newest processed game (epoch seconds); the tracker's poll cursor
         double mult_upper = 1.0;
         double mult_lower = 1.0;
         double mult_core = 1.0;
@@ -74,37 +84,95 @@ namespace Server::DB
         int pending_penance_count;
     };
 
+    struct LeaderboardEntry
+    {
+        int64_t user_id; // Discord ID
+        std::string name; // Riot name of one of the user's linked accounts
+        double value;     // Reps, deaths, or (kills + assists) / deaths
+        size_t rank;      // 1-based
+    };
+
+    struct LeaderboardPage
+    {
+        std::vector<LeaderboardEntry> entries;
+        size_t total = 0; // Ranked users on the whole board
+    };
+
     class Database
     {
     public:
-        Database(const std::string &dbPath);
+        // Writes go through one connection; reads are spread over `readConnections` read-only
+        // connections, which WAL lets run alongside each other and alongside the writer (0 = reads
+        // share the writer connection, as do in-memory databases).
+        Database(const std::string &dbPath, size_t readConnections = 4);
         ~Database();
 
         void Initialize();
 
+        /**
+         * @brief Unit of work: every write made through this Database on the constructing thread until
+         * Commit() lands in one atomic commit (one WAL write instead of one per statement). Reads on that
+         * thread go through the writer connection so they see the uncommitted rows; other threads'
+         * writes wait until it ends. Rolled back if destroyed without Commit(), or if a statement in it
+         * failed. A Transaction opened while one is already open on the thread is a savepoint inside it:
+         * its rollback undoes only its own writes, and its commit only becomes durable with the outer one.
+         * A failure inside a savepoint does not fail the enclosing level (the write-behind queue relies on
+         * that); methods that use one, like LogGame and AddToQueue, report it through their result instead.
+         * Keep it short: no network I/O or waiting while it is open.
+         */
+        class Transaction
+        {
+        public:
+            explicit Transaction(Database &db);
+            Transaction(const Transaction &) = delete;
+            Transaction &operator=(const Transaction &) = delete;
+            ~Transaction();
+
+            /// @brief Commits (or releases the savepoint) and returns whether its writes were kept.
+            bool Commit();
+
+        private:
+            Database &m_db;
+            std::unique_lock<std::recursive_mutex> m_lock;
+            int m_depth;               // 1 = outermost
+            size_t m_boardMark;        // Leaderboard changes staged before this level began
+            bool m_outerFailed = false; // Enclosing transaction's failure flag, restored when this one ends
+            bool m_open = true;
+        };
+
         // User Management
         void AddUser(const User &user);
         std::vector<User> GetDiscordUsers(int64_t discord_id);
         std::vector<User> GetAllUsers();
-        void UpdateLastMatch(int64_t discord_id, const std::string &puuid, const std::string &match_id);
+        // Advances the link's cursor to `match_time` (epoch seconds); never moves it backwards
+        void UpdateLastMatch(int64_t discord_id, const std::string &puuid, const std::string &match_id, int64_t match_time);
 
         // Multiplier Management
         void SetUserMultiplier(int64_t discord_id, double multiplier, const std::string &type = "");
         double GetUserMultiplier(int64_t discord_id, const std::string &type);
 
-        // Exercise Management
-        void SeedExercises(const std::vector<ExerciseDefinition> &exercises);
+        // Exercise Management. The table is mirrored in an in-memory catalog (rebuilt when it is reseeded),
+        // so reading and picking exercises never touches the database.
+        // `typeWeights`: relative odds per muscle group for random picks (see ExerciseCatalog)
+        void SeedExercises(const std::vector<ExerciseDefinition> &exercises, const std::map<std::string, double> &typeWeights = {});
         std::vector<ExerciseDefinition> GetAllExercises();
         std::optional<ExerciseDefinition> GetRandomExercise();
+        std::shared_ptr<const ExerciseCatalog> GetExerciseCatalog() const { return m_catalog.load(); }
 
         // Queue Management
-        void AddToQueue(int64_t user_id, const std::string &match_id, const std::string &exercise, int reps, int deaths);
+        // Returns false if a write failed; inside a Transaction the caller must then roll its own back
+        bool AddToQueue(int64_t user_id, const std::string &match_id, const std::string &exercise, int reps, int deaths);
         std::vector<ExerciseQueueItem> GetPendingPenance(int64_t user_id);
 
         // Rich Displays
         std::vector<PenanceDisplayInfo> GetPendingPenanceDetailed(int64_t user_id);
         std::vector<PenanceDisplayInfo> GetRecentGames(int64_t user_id, int limit);
-        std::vector<std::pair<std::string, int>> GetLeaderboard(const std::string& type);
+        // One page of the "reps", "deaths" or "kda" board, for everyone (guild_id 0) or for the users seen
+        // in a guild. Served from an in-memory index that each committed write updates, so it never scans
+        // history; empty for an unknown type.
+        LeaderboardPage GetLeaderboard(const std::string &type, int64_t guild_id = 0, size_t offset = 0, size_t limit = 10);
+        // Puts the user on the guild's boards; a no-op when they are already on them
+        void RecordGuildMember(int64_t guild_id, int64_t user_id);
 
         std::optional<ExerciseQueueItem> GetPenanceByGameID(int64_t user_id, const std::string &match_id);
 
@@ -113,18 +181,83 @@ namespace Server::DB
 
         // Stats & Logic
         bool IsMatchProcessed(int64_t discord_id, const std::string &match_id);
+        // End time (epoch seconds) of an already logged game, or nullopt if it hasn't been processed
+        std::optional<int64_t> GetProcessedMatchEnd(int64_t discord_id, const std::string &match_id);
 
-        void LogGame(int64_t user_id, const std::string &match_id, int64_t timestamp, int64_t gameDuration, const std::string &champ, int k, int d,
+        // Returns true once the game is stored, including when it already was; false if a write failed.
+        // Its writes are a savepoint, so a failure is not seen by an enclosing Transaction: check the result.
+        bool LogGame(int64_t user_id, const std::string &match_id, int64_t timestamp, int64_t gameDuration, const std::string &champ, int k, int d,
                      int a, double kp, int cs, double cs_min);
+        // Reads the per-user summary tables, which LogGame, AddToQueue and CompletePenance keep up to date
+        // in the same transaction as their own write; the cost doesn't grow with the user's history
         UserStats GetUserStats(int64_t user_id);
+        // Recomputes the summary tables from games, exercise_queue and exercise_history, and reloads the
+        // leaderboards from them. Returns false (leaving them as they were) on failure.
+        bool RebuildUserStats();
 
     private:
+        // Writer connection; m_mutex serializes every write (and reads when there is no read pool).
+        // Recursive so a Transaction can hold it while the calls inside take it again.
         sqlite3 *m_db;
-        std::mutex m_mutex;
+        std::recursive_mutex m_mutex;
+        StatementCache m_statements; // Guarded by m_mutex
+
+        // Open transaction state, guarded by m_mutex. m_txOwner is also read without it, but only
+        // compares equal on the owning thread, which is the one that set it.
+        std::atomic<std::thread::id> m_txOwner{};
+        int m_txDepth = 0;
+        bool m_txFailed = false;
+
+        bool InTransaction() const { return m_txOwner.load(std::memory_order_relaxed) == std::this_thread::get_id(); }
+        bool EndTransaction(int depth, bool commit, bool outerFailed, size_t boardMark);
+
+        // Leaderboard changes made inside the open transaction, applied once it commits (guarded by
+        // m_mutex). Outside a transaction a change is applied right away.
+        std::unique_ptr<LeaderboardIndex> m_leaderboards;
+        std::vector<std::function<void(LeaderboardIndex &)>> m_boardPending;
+        void StageLeaderboard(std::function<void(LeaderboardIndex &)> change);
+        void LoadLeaderboards();
+
+        // Current exercise snapshot; replaced whole, never modified
+        std::atomic<std::shared_ptr<const ExerciseCatalog>> m_catalog;
+        void LoadExerciseCatalog(const std::map<std::string, double> &typeWeights);
+
+        // Read-only pool. A connection is leased by one thread at a time, with its own statement cache.
+        struct ReadConnection
+        {
+            sqlite3 *db = nullptr;
+            StatementCache statements;
+        };
+
+        class ReaderLease
+        {
+        public:
+            ReaderLease(Database &owner, ReadConnection *conn) : m_owner(owner), m_conn(conn) {}
+            ReaderLease(const ReaderLease &) = delete;
+            ReaderLease &operator=(const ReaderLease &) = delete;
+            ~ReaderLease() { m_owner.ReleaseReader(m_conn); }
+            ReadConnection *operator->() const { return m_conn; }
+
+        private:
+            Database &m_owner;
+            ReadConnection *m_conn;
+        };
+
+        void OpenReaders(const std::string &dbPath, size_t count);
+        ReaderLease AcquireReader();
+        void ReleaseReader(ReadConnection *conn);
+
+        std::vector<std::unique_ptr<ReadConnection>> m_readers;
+        std::vector<ReadConnection *> m_idleReaders; // Guarded by m_readerMutex
+        std::mutex m_readerMutex;
+        std::condition_variable m_readerAvailable;
         
         // Base Execute for raw SQL (migrations etc)
         void ExecuteSQL(const std::string &sql);
 
+        // Brings the schema up to the newest numbered migration (tracked in PRAGMA user_version)
+        void Migrate();
+
         // Binding Helpers
         void BindParameter(sqlite3_stmt *stmt, int index, int value)
         {
@@ -166,41 +299,68 @@ namespace Server::DB
             (BindParameter(stmt, i++, std::forward<Args>(args)), ...);
         }
 
-        // Variadic Execute
+        // Variadic Execute; returns the number of rows it changed
         template <typename... Args>
-        void Execute(const std::string &sql, Args &&...args)
+        int Execute(const std::string &sql, Args &&...args)
         {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            sqlite3_stmt *stmt;
-            if (sqlite3_prepare_v2(m_db, sql.c_str(), -1, &stmt, 0) != SQLITE_OK)
+            std::lock_guard<std::recursive_mutex> lock(m_mutex);
+            auto handle = m_statements.Acquire(sql);
+            if (!handle)
             {
-                std::cerr << "SQL Error (Prepare): " << sqlite3_errmsg(m_db) << "\nSQL: " << sql << std::endl;
-                return;
+                m_txFailed = m_txDepth > 0;
+                return 0;
             }
+            sqlite3_stmt *stmt = handle.get();
 
             Bind(stmt, 1, std::forward<Args>(args)...);
 
-            if (sqlite3_step(stmt) != SQLITE_DONE)
+            // Note: STEP returning ROW is not an error but Execute is usually for non-query
+            int rc = sqlite3_step(stmt);
+            if (rc != SQLITE_DONE && rc != SQLITE_ROW)
             {
-               // Note: STEP returning ROW is not an error but Execute is usually for non-query
-               // const char* err = sqlite3_errmsg(m_db);
-               // std::cerr << "SQL Info (Step): " << err << "\nSQL: " << sql << std::endl;
+                std::cerr << "SQL Error (Step): " << sqlite3_errmsg(m_db) << "\nSQL: " << sql << std::endl;
+                if (m_txDepth > 0)
+                    m_txFailed = true; // Rolls the whole unit of work back instead of committing half of it
+                return 0;
             }
-            sqlite3_finalize(stmt);
+            return sqlite3_changes(m_db);
         }
 
-        // Variadic Query
+        // Variadic Query (read pool when there is one, unless this thread has a transaction open)
         template <typename T, typename Func, typename... Args>
         std::vector<T> Query(const std::string &sql, Func mapper, Args &&...args)
         {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            std::vector<T> results;
-            sqlite3_stmt *stmt;
-            if (sqlite3_prepare_v2(m_db, sql.c_str(), -1, &stmt, 0) != SQLITE_OK)
+            if (!m_readers.empty() && !InTransaction())
             {
-                std::cerr << "SQL Error (Prepare): " << sqlite3_errmsg(m_db) << "\nSQL: " << sql << std::endl;
-                return results;
+                auto reader = AcquireReader();
+                return RunQuery<T>(reader->statements, sql, mapper, std::forward<Args>(args)...);
+            }
+            std::lock_guard<std::recursive_mutex> lock(m_mutex);
+            return RunQuery<T>(m_statements, sql, mapper, std::forward<Args>(args)...);
+        }
+
+        // Variadic QuerySingle (same routing as Query)
+        template <typename T, typename Func, typename... Args>
+        std::optional<T> QuerySingle(const std::string &sql, Func mapper, Args &&...args)
+        {
+            if (!m_readers.empty() && !InTransaction())
+            {
+                auto reader = AcquireReader();
+                return RunQuerySingle<T>(reader->statements, sql, mapper, std::forward<Args>(args)...);
             }
+            std::lock_guard<std::recursive_mutex> lock(m_mutex);
+            return RunQuerySingle<T>(m_statements, sql, mapper, std::forward<Args>(args)...);
+        }
+
+        // Query bodies; the caller holds the connection that owns `statements`
+        template <typename T, typename Func, typename... Args>
+        std::vector<T> RunQuery(StatementCache &statements, const std::string &sql, Func mapper, Args &&...args)
+        {
+            std::vector<T> results;
+            auto handle = statements.Acquire(sql);
+            if (!handle)
+                return results;
+            sqlite3_stmt *stmt = handle.get();
 
             Bind(stmt, 1, std::forward<Args>(args)...);
 
@@ -208,21 +368,16 @@ namespace Server::DB
             {
                 results.push_back(mapper(stmt));
             }
-            sqlite3_finalize(stmt);
             return results;
         }
 
-        // Variadic QuerySingle
         template <typename T, typename Func, typename... Args>
-        std::optional<T> QuerySingle(const std::string &sql, Func mapper, Args &&...args)
+        std::optional<T> RunQuerySingle(StatementCache &statements, const std::string &sql, Func mapper, Args &&...args)
         {
-            std::lock_guard<std::mutex> lock(m_mutex);
-             sqlite3_stmt *stmt;
-            if (sqlite3_prepare_v2(m_db, sql.c_str(), -1, &stmt, 0) != SQLITE_OK)
-            {
-                std::cerr << "SQL Error (Prepare): " << sqlite3_errmsg(m_db) << "\nSQL: " << sql << std::endl;
+            auto handle = statements.Acquire(sql);
+            if (!handle)
                 return std::nullopt;
-            }
+            sqlite3_stmt *stmt = handle.get();
 
             Bind(stmt, 1, std::forward<Args>(args)...);
 
@@ -231,7 +386,6 @@ namespace Server::DB
             {
                 result = mapper(stmt);
             }
-            sqlite3_finalize(stmt);
             return result;
         }
     };
@@ -0,0 +1,69 @@
+#include "server/database/ExerciseCatalog.h"
+#include <algorithm>
+
+namespace Server::DB
+{
+    namespace
+    {
+        // One generator per thread: no lock on the hot path, and no shared state to race on
+        std::mt19937 &ThreadRng()
+        {
+            thread_local std::mt19937 rng(std::random_device{}());
+            return rng;
+        }
+    } // namespace
+
+    ExerciseCatalog::ExerciseCatalog(std::vector<ExerciseDefinition> exercises, const std::map<std::string, double> &typeWeights)
+        : m_exercises(std::move(exercises))
+    {
+        for (size_t i = 0; i < m_exercises.size(); ++i)
+        {
+            auto [it, added] = m_groupByType.emplace(m_exercises[i].type, m_groups.size());
+            if (added)
+                m_groups.push_back(TypeGroup{m_exercises[i].type, {}});
+            m_groups[it->second].members.push_back(i);
+        }
+
+        std::vector<double> weights;
+        weights.reserve(m_groups.size());
+        for (const auto &group : m_groups)
+        {
+            auto weight = typeWeights.find(group.type);
+            weights.push_back(weight != typeWeights.end() ? std::max(0.0, weight->second)
+                                                          : static_cast<double>(group.members.size()));
+        }
+        // Every group weighted 0 would leave nothing to draw; fall back to per-exercise odds
+        if (std::none_of(weights.begin(), weights.end(), [](double w) { return w > 0.0; }))
+        {
+            for (size_t i = 0; i < m_groups.size(); ++i)
+                weights[i] = static_cast<double>(m_groups[i].members.size());
+        }
+        double total = 0.0;
+        for (double weight : weights)
+            m_cumulativeWeights.push_back(total += weight);
+    }
+
+    std::optional<ExerciseDefinition> ExerciseCatalog::PickRandom() const
+    {
+        if (m_groups.empty())
+            return std::nullopt;
+        std::uniform_real_distribution<double> draw(0.0, m_cumulativeWeights.back());
+        auto it = std::upper_bound(m_cumulativeWeights.begin(), m_cumulativeWeights.end(), draw(ThreadRng()));
+        size_t group = std::min<size_t>(it - m_cumulativeWeights.begin(), m_groups.size() - 1);
+        return PickFrom(m_groups[group]);
+    }
+
+    std::optional<ExerciseDefinition> ExerciseCatalog::PickRandom(const std::string &type) const
+    {
+        auto it = m_groupByType.find(type);
+        if (it == m_groupByType.end())
+            return std::nullopt;
+        return PickFrom(m_groups[it->second]);
+    }
+
+    const ExerciseDefinition &ExerciseCatalog::PickFrom(const TypeGroup &group) const
+    {
+        std::uniform_int_distribution<size_t> pick(0, group.members.size() - 1);
+        return m_exercises[group.members[pick(ThreadRng())]];
+    }
+} // namespace Server::DB
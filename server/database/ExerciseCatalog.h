@@ -0,0 +1,46 @@
+#pragma once
+#include "server/database/Database.h"
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace Server::DB
+{
+    /**
+     * @brief Immutable snapshot of the exercise table, for picking penance exercises without touching
+     * the database. Selection first draws a muscle group by its weight, then an exercise of that group
+     * uniformly. A group without a weight (or every group, if all weights are 0) counts 1 per exercise,
+     * so with no weights configured every exercise is equally likely, as before. Safe to share between
+     * threads; Database swaps in a new snapshot whenever the table is reseeded.
+     */
+    class ExerciseCatalog
+    {
+    public:
+        ExerciseCatalog(std::vector<ExerciseDefinition> exercises, const std::map<std::string, double> &typeWeights = {});
+
+        /// @brief A random exercise, or nullopt if the catalog is empty.
+        std::optional<ExerciseDefinition> PickRandom() const;
+
+        /// @brief A random exercise of one muscle group, or nullopt if it has none.
+        std::optional<ExerciseDefinition> PickRandom(const std::string &type) const;
+
+        const std::vector<ExerciseDefinition> &All() const { return m_exercises; }
+        bool Empty() const { return m_exercises.empty(); }
+
+    private:
+        struct TypeGroup
+        {
+            std::string type;
+            std::vector<size_t> members; // Indices into m_exercises
+        };
+
+        const ExerciseDefinition &PickFrom(const TypeGroup &group) const;
+
+        std::vector<ExerciseDefinition> m_exercises;
+        std::vector<TypeGroup> m_groups;
+        std::map<std::string, size_t> m_groupByType;
+        std::vector<double> m_cumulativeWeights; // Running sum of the group weights, in m_groups order
+    };
+} // namespace Server::DB
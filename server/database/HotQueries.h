@@ -0,0 +1,93 @@
+#pragma once
+#include <string>
+
+// SQL of the statements on the hot paths: tracker polls, the penance commands and /stats. Database runs
+// exactly these strings, and server/tests/QueryPlanTest.cpp checks that every one of them is answered
+// from an index, so a query added to a hot path belongs here (and in ALL) too.
+namespace Server::DB::HotSql
+{
+    // Tracker: per-account polls and match recording
+    inline constexpr const char *GET_DISCORD_USERS = "SELECT * FROM users WHERE discord_id = ?";
+    inline constexpr const char *UPDATE_LAST_MATCH =
+        "UPDATE users SET last_match_id = ?, last_match_time = ? "
+        "WHERE discord_id = ? AND riot_puuid = ? AND COALESCE(last_match_time, 0) <= ?";
+    inline constexpr const char *IS_MATCH_PROCESSED = "SELECT 1 FROM games WHERE match_id = ? AND user_id = ? LIMIT 1";
+    inline constexpr const char *GET_PROCESSED_MATCH_END = "SELECT timestamp / 1000 + COALESCE(game_duration, 0) FROM games WHERE match_id = ? AND user_id = ? LIMIT 1";
+    inline constexpr const char *LOG_GAME =
+        "INSERT OR IGNORE INTO games (match_id, user_id, timestamp, champion_name, kills, deaths, "
+        "assists, kp_percent, cs_total, cs_min, game_duration) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+    inline constexpr const char *LOG_GAME_STATS =
+        "INSERT INTO user_stats (user_id, total_games, total_deaths, max_deaths, total_duration, lowest_kda, total_kills_assists) "
+        "VALUES (?, 1, ?, ?, ?, ?, ?) ON CONFLICT (user_id) DO UPDATE SET "
+        "total_games = total_games + 1, total_deaths = total_deaths + excluded.total_deaths, "
+        "max_deaths = MAX(max_deaths, excluded.max_deaths), total_duration = total_duration + excluded.total_duration, "
+        "lowest_kda = MIN(COALESCE(lowest_kda, excluded.lowest_kda), COALESCE(excluded.lowest_kda, lowest_kda)), "
+        "total_kills_assists = total_kills_assists + excluded.total_kills_assists";
+    inline constexpr const char *LOG_GAME_CHAMPION_DEATHS =
+        "INSERT INTO user_champion_deaths (user_id, champion_name, deaths) VALUES (?, ?, ?) "
+        "ON CONFLICT (user_id, champion_name) DO UPDATE SET deaths = deaths + excluded.deaths";
+    inline constexpr const char *ADD_TO_QUEUE = "INSERT INTO exercise_queue (user_id, match_id, exercise_name, reps, original_deaths) VALUES (?, ?, ?, ?, ?)";
+    inline constexpr const char *ADD_TO_QUEUE_STATS =
+        "INSERT INTO user_stats (user_id, pending_penance) VALUES (?, 1) "
+        "ON CONFLICT (user_id) DO UPDATE SET pending_penance = pending_penance + 1";
+
+    // Penance commands
+    inline constexpr const char *GET_PENDING_PENANCE =
+        "SELECT id, user_id, match_id, exercise_name, reps, original_deaths, timestamp FROM "
+        "exercise_queue WHERE user_id = ?";
+    inline constexpr const char *GET_PENDING_PENANCE_DETAILED = R"(
+            SELECT 
+                eq.id, eq.match_id, eq.exercise_name, eq.reps, eq.original_deaths,
+                g.champion_name, g.kills, g.deaths, g.assists, g.kp_percent, g.cs_total, g.cs_min, g.timestamp
+            FROM exercise_queue eq
+            LEFT JOIN games g ON eq.match_id = g.match_id AND eq.user_id = g.user_id
+            WHERE eq.user_id = ?
+            ORDER BY eq.id DESC
+        )";
+    inline constexpr const char *GET_PENANCE_BY_GAME_ID =
+        "SELECT id, user_id, match_id, exercise_name, reps, original_deaths, timestamp FROM "
+        "exercise_queue WHERE user_id = ? AND match_id = ? LIMIT 1";
+    inline constexpr const char *COMPLETE_PENANCE_DELETE = "DELETE FROM exercise_queue WHERE id = ?";
+    inline constexpr const char *COMPLETE_PENANCE_STATS = "UPDATE user_stats SET pending_penance = MAX(pending_penance - 1, 0) WHERE user_id = ?";
+    inline constexpr const char *UPDATE_PENANCE = "UPDATE exercise_queue SET exercise_name = ?, reps = ? WHERE id = ?";
+
+    // /stats and /history
+    inline constexpr const char *GET_RECENT_GAMES =
+        "SELECT match_id, user_id, timestamp, champion_name, kills, deaths, assists, kp_percent, cs_total, "
+        "cs_min FROM games WHERE user_id = ? ORDER BY timestamp DESC LIMIT ?";
+    inline constexpr const char *GET_USER_STATS_TOTALS = "SELECT total_deaths, total_games, max_deaths, total_duration, lowest_kda, pending_penance FROM user_stats WHERE user_id = ?";
+    inline constexpr const char *GET_USER_STATS_EXERCISES = "SELECT exercise_name, reps FROM user_exercise_totals WHERE user_id = ?";
+    inline constexpr const char *GET_USER_STATS_CHAMPIONS = "SELECT champion_name, deaths FROM user_champion_deaths WHERE user_id = ? ORDER BY deaths DESC LIMIT 3";
+
+    // GetUserMultiplier; `column` is one of wimp_mult_upper, wimp_mult_lower, wimp_mult_core
+    inline std::string UserMultiplier(const std::string &column) { return "SELECT " + column + " FROM users WHERE discord_id = ? LIMIT 1"; }
+
+    struct Entry
+    {
+        const char *caller;
+        const char *sql;
+    };
+
+    // Every constant above, named after the Database method that runs it
+    inline constexpr Entry ALL[] = {
+        {"GetDiscordUsers", GET_DISCORD_USERS},
+        {"UpdateLastMatch", UPDATE_LAST_MATCH},
+        {"IsMatchProcessed", IS_MATCH_PROCESSED},
+        {"GetProcessedMatchEnd", GET_PROCESSED_MATCH_END},
+        {"LogGame", LOG_GAME},
+        {"LogGame (user_stats)", LOG_GAME_STATS},
+        {"LogGame (user_champion_deaths)", LOG_GAME_CHAMPION_DEATHS},
+        {"AddToQueue", ADD_TO_QUEUE},
+        {"AddToQueue (user_stats)", ADD_TO_QUEUE_STATS},
+        {"GetPendingPenance", GET_PENDING_PENANCE},
+        {"GetPendingPenanceDetailed", GET_PENDING_PENANCE_DETAILED},
+        {"GetPenanceByGameID", GET_PENANCE_BY_GAME_ID},
+        {"CompletePenance (delete)", COMPLETE_PENANCE_DELETE},
+        {"CompletePenance (user_stats)", COMPLETE_PENANCE_STATS},
+        {"UpdatePenance", UPDATE_PENANCE},
+        {"GetRecentGames", GET_RECENT_GAMES},
+        {"GetUserStats (totals)", GET_USER_STATS_TOTALS},
+        {"GetUserStats (exercises)", GET_USER_STATS_EXERCISES},
+        {"GetUserStats (champions)", GET_USER_STATS_CHAMPIONS},
+    };
+} // namespace Server::DB::HotSql
@@ -0,0 +1,133 @@
+#include "server/database/LeaderboardIndex.h"
+#include <algorithm>
+#include <iterator>
+#include <mutex>
+
+namespace Server::DB
+{
+    std::optional<LeaderboardCategory> LeaderboardIndex::ParseCategory(const std::string &name)
+    {
+        if (name == "reps")
+            return LeaderboardCategory::Reps;
+        if (name == "deaths")
+            return LeaderboardCategory::Deaths;
+        if (name == "kda")
+            return LeaderboardCategory::Kda;
+        return std::nullopt;
+    }
+
+    void LeaderboardIndex::Assign(LeaderboardIndex &&fresh)
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        m_users = std::move(fresh.m_users);
+        m_global = std::move(fresh.m_global);
+        m_guilds = std::move(fresh.m_guilds);
+    }
+
+    std::optional<double> LeaderboardIndex::Score(const UserEntry &user, LeaderboardCategory category)
+    {
+        if (!user.name)
+            return std::nullopt;
+        const Totals &t = user.totals;
+        switch (category)
+        {
+        case LeaderboardCategory::Reps:
+            return t.reps > 0 ? std::optional<double>(static_cast<double>(t.reps)) : std::nullopt;
+        case LeaderboardCategory::Deaths:
+            return t.games > 0 ? std::optional<double>(static_cast<double>(t.deaths)) : std::nullopt;
+        case LeaderboardCategory::Kda:
+            if (t.games <= 5)
+                return std::nullopt;
+            return static_cast<double>(t.kills_assists) / std::max<int64_t>(t.deaths, 1);
+        }
+        return std::nullopt;
+    }
+
+    void LeaderboardIndex::Rerank(int64_t user_id, const UserEntry &before, const UserEntry &after)
+    {
+        for (size_t c = 0; c < CATEGORY_COUNT; ++c)
+        {
+            auto category = static_cast<LeaderboardCategory>(c);
+            auto oldScore = Score(before, category);
+            auto newScore = Score(after, category);
+            if (oldScore == newScore)
+                continue;
+
+            auto move = [&](std::set<Key> &board) {
+                if (oldScore)
+                    board.erase(Key{*oldScore, user_id});
+                if (newScore)
+                    board.insert(Key{*newScore, user_id});
+            };
+            move(m_global[c]);
+            for (int64_t guild : after.guilds)
+                move(m_guilds[guild][c]);
+        }
+    }
+
+    void LeaderboardIndex::Add(int64_t user_id, const Totals &delta)
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        UserEntry &user = m_users[user_id];
+        UserEntry before = user;
+        user.totals.games += delta.games;
+        user.totals.deaths += delta.deaths;
+        user.totals.kills_assists += delta.kills_assists;
+        user.totals.reps += delta.reps;
+        Rerank(user_id, before, user);
+    }
+
+    void LeaderboardIndex::SetName(int64_t user_id, const std::string &name)
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        UserEntry &user = m_users[user_id];
+        UserEntry before = user;
+        user.name = name.empty() ? "Unknown" : name;
+        Rerank(user_id, before, user);
+    }
+
+    void LeaderboardIndex::AddGuildMember(int64_t guild_id, int64_t user_id)
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        UserEntry &user = m_users[user_id];
+        if (std::find(user.guilds.begin(), user.guilds.end(), guild_id) != user.guilds.end())
+            return;
+        user.guilds.push_back(guild_id);
+
+        Boards &boards = m_guilds[guild_id];
+        for (size_t c = 0; c < CATEGORY_COUNT; ++c)
+        {
+            if (auto score = Score(user, static_cast<LeaderboardCategory>(c)))
+                boards[c].insert(Key{*score, user_id});
+        }
+    }
+
+    bool LeaderboardIndex::IsGuildMember(int64_t guild_id, int64_t user_id) const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        auto it = m_users.find(user_id);
+        return it != m_users.end() && std::find(it->second.guilds.begin(), it->second.guilds.end(), guild_id) != it->second.guilds.end();
+    }
+
+    LeaderboardPage LeaderboardIndex::Page(LeaderboardCategory category, int64_t guild_id, size_t offset, size_t limit) const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        LeaderboardPage page;
+        const std::set<Key> *board = &m_global[static_cast<size_t>(category)];
+        if (guild_id != 0)
+        {
+            auto guild = m_guilds.find(guild_id);
+            if (guild == m_guilds.end())
+                return page;
+            board = &guild->second[static_cast<size_t>(category)];
+        }
+
+        page.total = board->size();
+        if (offset >= board->size())
+            return page;
+        auto it = std::next(board->begin(), static_cast<std::ptrdiff_t>(offset));
+        for (size_t rank = offset + 1; it != board->end() && page.entries.size() < limit; ++it, ++rank)
+            page.entries.push_back(LeaderboardEntry{it->user_id, *m_users.at(it->user_id).name, it->score, rank});
+        return page;
+    }
+} // namespace Server::DB
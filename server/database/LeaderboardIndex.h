@@ -0,0 +1,89 @@
+#pragma once
+#include "server/database/Database.h"
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Server::DB
+{
+    enum class LeaderboardCategory
+    {
+        Reps,   // Reps completed
+        Deaths, // Deaths over all logged games
+        Kda,    // (kills + assists) / deaths over all logged games, for users with more than 5 games
+    };
+
+    /**
+     * @brief In-memory rankings for /leaderboard, one per category for everyone and one per category for
+     * each guild. Holds per-Discord-user running totals (all linked Riot accounts together), so a change
+     * moves one user in the rankings they are part of instead of re-aggregating history. Database loads it
+     * from the summary tables at startup and feeds it each committed write. Safe to share between threads.
+     */
+    class LeaderboardIndex
+    {
+    public:
+        struct Totals
+        {
+            int64_t games = 0;
+            int64_t deaths = 0;
+            int64_t kills_assists = 0;
+            int64_t reps = 0;
+        };
+
+        static std::optional<LeaderboardCategory> ParseCategory(const std::string &name);
+
+        /// @brief Replaces everything with the contents of `fresh` (a reload), in one step for readers.
+        void Assign(LeaderboardIndex &&fresh);
+
+        /// @brief Adds `delta` to a user's totals (a user without a linked account is kept but not ranked).
+        void Add(int64_t user_id, const Totals &delta);
+
+        /// @brief Sets the name shown for a user and ranks them; an empty name shows as "Unknown".
+        void SetName(int64_t user_id, const std::string &name);
+
+        /// @brief Ranks a user on the guild's boards too.
+        void AddGuildMember(int64_t guild_id, int64_t user_id);
+        bool IsGuildMember(int64_t guild_id, int64_t user_id) const;
+
+        /// @brief Entries [offset, offset + limit) of a board (guild_id 0 = everyone). Costs
+        /// O(log n + offset + limit), whatever the size of the history behind it.
+        LeaderboardPage Page(LeaderboardCategory category, int64_t guild_id, size_t offset, size_t limit) const;
+
+    private:
+        static constexpr size_t CATEGORY_COUNT = 3;
+
+        struct UserEntry
+        {
+            Totals totals;
+            std::optional<std::string> name; // Set once the user has a linked account
+            std::vector<int64_t> guilds;
+        };
+
+        // Best first; ties go to the lower user ID so pages are stable
+        struct Key
+        {
+            double score;
+            int64_t user_id;
+            bool operator<(const Key &other) const
+            {
+                return score != other.score ? score > other.score : user_id < other.user_id;
+            }
+        };
+        using Boards = std::array<std::set<Key>, CATEGORY_COUNT>;
+
+        static std::optional<double> Score(const UserEntry &user, LeaderboardCategory category);
+
+        // Caller holds m_mutex exclusively; `before` is the user as they were ranked until now
+        void Rerank(int64_t user_id, const UserEntry &before, const UserEntry &after);
+
+        mutable std::shared_mutex m_mutex;
+        std::unordered_map<int64_t, UserEntry> m_users;
+        Boards m_global;
+        std::unordered_map<int64_t, Boards> m_guilds;
+    };
+} // namespace Server::DB
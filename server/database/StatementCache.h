@@ -0,0 +1,122 @@
+#pragma once
+
+#include <iostream>
+#include <sqlite3.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace Server::DB
+{
+    /**
+     * @brief Prepared statements of one connection, keyed by SQL text.
+     * Each distinct statement is compiled once and reused; Acquire() hands it out through a Handle that
+     * resets it and clears its bindings when released. Not thread-safe: callers serialize access to the
+     * connection (and therefore to its cache).
+     */
+    class StatementCache
+    {
+    public:
+        // Distinct statements kept per connection; beyond this, new SQL texts are prepared per call.
+        // Every statement in this codebase is a literal or one of a few variants, so this is only a guard.
+        static constexpr size_t MAX_STATEMENTS = 256;
+
+        class Handle
+        {
+        public:
+            Handle() = default;
+            Handle(sqlite3_stmt *stmt, bool *inUse) : m_stmt(stmt), m_inUse(inUse) {}
+            Handle(Handle &&other) noexcept
+                : m_stmt(std::exchange(other.m_stmt, nullptr)), m_inUse(std::exchange(other.m_inUse, nullptr))
+            {
+            }
+            Handle(const Handle &) = delete;
+            Handle &operator=(const Handle &) = delete;
+            ~Handle() { Release(); }
+
+            sqlite3_stmt *get() const { return m_stmt; }
+            explicit operator bool() const { return m_stmt != nullptr; }
+
+        private:
+            void Release()
+            {
+                if (!m_stmt)
+                    return;
+                if (m_inUse)
+                {
+                    // Cached: leave it ready for the next caller
+                    sqlite3_reset(m_stmt);
+                    sqlite3_clear_bindings(m_stmt);
+                    *m_inUse = false;
+                }
+                else
+                {
+                    sqlite3_finalize(m_stmt); // One-off (cache full or statement already borrowed)
+                }
+                m_stmt = nullptr;
+            }
+
+            sqlite3_stmt *m_stmt = nullptr;
+            bool *m_inUse = nullptr;
+        };
+
+        explicit StatementCache(sqlite3 *db = nullptr) : m_db(db) {}
+        StatementCache(const StatementCache &) = delete;
+        StatementCache &operator=(const StatementCache &) = delete;
+        ~StatementCache() { Clear(); }
+
+        void Attach(sqlite3 *db)
+        {
+            Clear();
+            m_db = db;
+        }
+
+        /// @brief Returns the prepared statement for `sql`, compiling it on first use.
+        /// An empty handle means the SQL failed to compile (the error is logged).
+        Handle Acquire(const std::string &sql)
+        {
+            auto it = m_statements.find(sql);
+            if (it != m_statements.end() && !it->second.in_use)
+            {
+                it->second.in_use = true;
+                return Handle(it->second.stmt, &it->second.in_use);
+            }
+
+            sqlite3_stmt *stmt = nullptr;
+            if (sqlite3_prepare_v3(m_db, sql.c_str(), -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK)
+            {
+                std::cerr << "SQL Error (Prepare): " << sqlite3_errmsg(m_db) << "\nSQL: " << sql << std::endl;
+                sqlite3_finalize(stmt);
+                return Handle();
+            }
+
+            // Re-entrant use of a borrowed statement, or a full cache: hand out a one-off copy
+            if (it != m_statements.end() || m_statements.size() >= MAX_STATEMENTS)
+                return Handle(stmt, nullptr);
+
+            auto &entry = m_statements.emplace(sql, Entry{stmt, true}).first->second;
+            return Handle(entry.stmt, &entry.in_use);
+        }
+
+        /// @brief Finalizes every cached statement. Required before the connection is closed.
+        void Clear()
+        {
+            for (auto &[sql, entry] : m_statements)
+                sqlite3_finalize(entry.stmt);
+            m_statements.clear();
+        }
+
+        size_t size() const { return m_statements.size(); }
+
+    private:
+        struct Entry
+        {
+            sqlite3_stmt *stmt;
+            bool in_use;
+        };
+
+        sqlite3 *m_db;
+        // Node-based map: entry addresses (handed to Handles) stay valid as it grows
+        std::unordered_map<std::string, Entry> m_statements;
+    };
+} // namespace Server::DB
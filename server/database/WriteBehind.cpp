@@ -0,0 +1,181 @@
+#include "server/database/WriteBehind.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace Server::DB
+{
+    WriteBehind::WriteBehind(std::shared_ptr<Database> db, WriteBehindOptions options) : m_state(std::make_shared<State>())
+    {
+        m_state->db = std::move(db);
+        m_state->options = options;
+        m_state->options.batch_ops = std::max<size_t>(1, options.batch_ops);
+        m_state->next_stats_log = std::chrono::steady_clock::now() + options.stats_interval;
+        m_thread = std::thread(&WriteBehind::WriterLoop, m_state);
+    }
+
+    WriteBehind::~WriteBehind()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_state->mutex);
+            m_state->stop = true;
+        }
+        m_state->wake.notify_one();
+        if (!m_thread.joinable())
+            return;
+        // Destroyed by one of our own completions: the loop drains the rest and exits by itself
+        if (m_thread.get_id() == std::this_thread::get_id())
+            m_thread.detach();
+        else
+            m_thread.join();
+    }
+
+    void WriteBehind::Submit(Operation op, Completion done)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_state->mutex);
+            m_state->queue.push_back(Pending{std::move(op), std::move(done), std::chrono::steady_clock::now()});
+            m_state->submitted++;
+            m_state->high_water = std::max(m_state->high_water, m_state->queue.size());
+        }
+        m_state->wake.notify_one();
+    }
+
+    void WriteBehind::Flush()
+    {
+        if (std::this_thread::get_id() == m_thread.get_id())
+            return; // Called from a completion: everything before it has ended already
+
+        State &state = *m_state;
+        std::unique_lock<std::mutex> lock(state.mutex);
+        uint64_t target = state.submitted;
+        if (state.finished_ops >= target)
+            return;
+
+        state.flush_waiters++;
+        state.wake.notify_one(); // Don't make the caller sit out the batch window
+        state.finished.wait(lock, [&] { return state.finished_ops >= target; });
+        state.flush_waiters--;
+    }
+
+    size_t WriteBehind::QueueDepth() const
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        return m_state->queue.size();
+    }
+
+    void WriteBehind::WriterLoop(std::shared_ptr<State> statePtr)
+    {
+        State &state = *statePtr;
+        std::unique_lock<std::mutex> lock(state.mutex);
+        while (true)
+        {
+            // Idle: wake for work, or for the next stats line
+            auto ready = [&] { return state.stop || !state.queue.empty(); };
+            if (state.options.stats_interval.count() > 0)
+                state.wake.wait_until(lock, state.next_stats_log, ready);
+            else
+                state.wake.wait(lock, ready);
+            MaybeLogStats(state, std::chrono::steady_clock::now());
+            if (state.queue.empty())
+            {
+                if (state.stop)
+                    break;
+                continue;
+            }
+
+            // Let the group fill up until its oldest operation has waited the batch window
+            auto closeAt = state.queue.front().submitted_at + state.options.batch_window;
+            state.wake.wait_until(lock, closeAt, [&] {
+                return state.stop || state.flush_waiters > 0 || state.queue.size() >= state.options.batch_ops;
+            });
+
+            size_t take = std::min(state.queue.size(), state.options.batch_ops);
+            std::vector<Pending> group;
+            group.reserve(take);
+            for (size_t i = 0; i < take; ++i)
+            {
+                group.push_back(std::move(state.queue.front()));
+                state.queue.pop_front();
+            }
+
+            lock.unlock();
+            CommitGroup(state, group);
+            group.clear(); // Captured state is released before flushers are told
+            lock.lock();
+
+            state.finished_ops += take;
+            state.finished.notify_all();
+        }
+    }
+
+    void WriteBehind::CommitGroup(State &state, std::vector<Pending> &group)
+    {
+        std::vector<bool> kept(group.size(), false);
+        bool committed = false;
+        {
+            Database::Transaction tx(*state.db);
+            for (size_t i = 0; i < group.size(); ++i)
+            {
+                Database::Transaction savepoint(*state.db);
+                try
+                {
+                    group[i].op(*state.db);
+                    kept[i] = savepoint.Commit();
+                }
+                catch (const std::exception &e)
+                {
+                    std::cerr << "[DB] Write-behind operation failed: " << e.what() << std::endl;
+                }
+            }
+            committed = tx.Commit();
+        }
+        if (!committed)
+            std::cerr << "[DB] Write-behind commit of " << group.size() << " operation(s) failed" << std::endl;
+
+        size_t failed = 0;
+        for (size_t i = 0; i < group.size(); ++i)
+        {
+            bool ok = committed && kept[i];
+            failed += ok ? 0 : 1;
+            if (!group[i].done)
+                continue;
+            try
+            {
+                group[i].done(ok);
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "[DB] Write-behind completion failed: " << e.what() << std::endl;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.commits++;
+        state.committed_ops += group.size() - failed;
+        state.failed_ops += failed;
+    }
+
+    void WriteBehind::MaybeLogStats(State &state, std::chrono::steady_clock::time_point now)
+    {
+        // Caller holds state.mutex
+        const auto interval = state.options.stats_interval;
+        if (interval.count() <= 0 || now < state.next_stats_log)
+            return;
+        state.next_stats_log = now + interval;
+
+        double seconds = static_cast<double>(interval.count());
+        double perCommit = state.commits ? static_cast<double>(state.committed_ops) / state.commits : 0.0;
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(2) << "[DB] Write-behind (last " << interval.count() << "s): commits=" << state.commits
+            << " (" << state.commits / seconds << "/s) ops=" << state.committed_ops << " (" << perCommit
+            << "/commit) failed=" << state.failed_ops << " queue depth=" << state.queue.size() << " hwm=" << state.high_water;
+        std::cout << out.str() << std::endl;
+
+        state.commits = 0;
+        state.committed_ops = 0;
+        state.failed_ops = 0;
+        state.high_water = state.queue.size();
+    }
+} // namespace Server::DB
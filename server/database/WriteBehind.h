@@ -0,0 +1,97 @@
+#pragma once
+#include "server/database/Database.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Server::DB
+{
+    struct WriteBehindOptions
+    {
+        // A group is committed once it holds this many operations...
+        size_t batch_ops = 64;
+        // ...or once its oldest operation has waited this long, whichever comes first.
+        std::chrono::milliseconds batch_window{20};
+
+        // How often commit rate and queue depth are logged (0 disables).
+        std::chrono::seconds stats_interval{300};
+    };
+
+    /**
+     * @brief Write-behind queue in front of the Database writer connection.
+     * Callers hand over write operations and return immediately; one writer thread runs them in submission
+     * order, grouping everything that arrived within the batch window into a single transaction (group
+     * commit). Each operation runs in its own savepoint, so one failing doesn't roll back its neighbours.
+     * Flush() is the barrier for callers that need to read their own writes.
+     */
+    class WriteBehind
+    {
+    public:
+        using Operation = std::function<void(Database &)>;
+        // Called on the writer thread once the operation's group has ended; `committed` is false if the
+        // operation (or the whole group) was rolled back.
+        using Completion = std::function<void(bool committed)>;
+
+        WriteBehind(std::shared_ptr<Database> db, WriteBehindOptions options = {});
+        // Commits everything still queued, then stops the writer thread
+        ~WriteBehind();
+
+        WriteBehind(const WriteBehind &) = delete;
+        WriteBehind &operator=(const WriteBehind &) = delete;
+
+        /// @brief Queues a write. `op` must only touch the database it is given.
+        void Submit(Operation op, Completion done = nullptr);
+
+        /// @brief Blocks until every operation submitted before the call has been committed or rolled
+        /// back, closing the current group early. Returns immediately on the writer thread itself.
+        void Flush();
+
+        /// @brief Operations queued and not yet picked up by the writer.
+        size_t QueueDepth() const;
+
+    private:
+        struct Pending
+        {
+            Operation op;
+            Completion done;
+            std::chrono::steady_clock::time_point submitted_at;
+        };
+
+        // Everything the writer thread touches. Shared with the thread, so a completion that drops the
+        // last reference to our owner (and so destroys us on the writer thread) doesn't pull it away.
+        struct State
+        {
+            std::shared_ptr<Database> db;
+            WriteBehindOptions options;
+
+            std::mutex mutex;
+            std::condition_variable wake;     // Writer: work arrived, a flush is waiting, or stopping
+            std::condition_variable finished; // Flushers: a group ended
+            std::deque<Pending> queue;
+            uint64_t submitted = 0; // Operations ever submitted; Flush waits for finished_ops to catch up
+            uint64_t finished_ops = 0;
+            size_t flush_waiters = 0;
+            bool stop = false;
+
+            // Reporting window, guarded by mutex
+            uint64_t commits = 0;
+            uint64_t committed_ops = 0;
+            uint64_t failed_ops = 0;
+            size_t high_water = 0;
+            std::chrono::steady_clock::time_point next_stats_log;
+        };
+
+        static void WriterLoop(std::shared_ptr<State> state);
+        static void CommitGroup(State &state, std::vector<Pending> &group);
+        static void MaybeLogStats(State &state, std::chrono::steady_clock::time_point now);
+
+        std::shared_ptr<State> m_state;
+        std::thread m_thread;
+    };
+} // namespace Server::DB
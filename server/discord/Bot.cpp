@@ -1,5 +1,6 @@
 #include "server/discord/Bot.h"
 #include "server/commands/CommandSystem.h"
+#include "server/tracker/PollSchedule.h"
 
 // Include Command Implementations
 #include "server/commands/impl/ForceFetch.h"
@@ -44,22 +45,16 @@ namespace Core::Discord
     {
         std::cout << "Bot is online as " << m_bot->me.username << std::endl;
 
-        // 1. Run immediately on startup
-        auto initialTask = std::make_unique<Utils::TaskTrackerUpdate>();
-        initialTask->priority = Utils::TaskPriority::Low;
-        initialTask->ctx = m_ctx;
-        m_taskManager->submit(std::move(initialTask));
-
-        // 2. Schedule recurring timer (300 seconds = 5 minutes)
-        m_bot->start_timer(
-            [this](const dpp::timer &timer)
-            {
-                auto task = std::make_unique<Utils::TaskTrackerUpdate>();
-                task->priority = Utils::TaskPriority::Low;
-                task->ctx = m_ctx;
-                m_taskManager->submit(std::move(task));
-            },
-            300);
+        // Recurring tracker sweep on the task manager's timer, starting right away. Once only: on_ready
+        // fires again after every reconnect. With a poll schedule each tick only polls the accounts that
+        // are due, so it ticks often; without one every tick polls everyone (300 seconds = 5 minutes).
+        // A tick that finds the Low queue full is skipped rather than piling onto a backed-up sweep.
+        if (dpp::run_once<struct StartTrackerSweeps>())
+        {
+            std::chrono::seconds tick = m_ctx->pollSchedule ? std::max(std::chrono::seconds(1), m_ctx->pollSchedule->Options().tick)
+                                                            : std::chrono::seconds(300);
+            m_taskManager->submit_every(tick, [ctx = m_ctx] { return MakeTrackerSweep(ctx); });
+        }
 
         if (dpp::run_once<struct RegisterBotCommands>())
         {
@@ -67,6 +62,14 @@ namespace Core::Discord
         }
     }
 
+    std::unique_ptr<Utils::Task> Bot::MakeTrackerSweep(std::shared_ptr<Utils::AppContext> ctx)
+    {
+        auto sweep = std::make_unique<Utils::TaskTrackerUpdate>();
+        sweep->priority = Utils::TaskPriority::Low;
+        sweep->ctx = ctx;
+        return sweep;
+    }
+
     void Bot::RegisterCommands()
     {
         std::vector<dpp::slashcommand> cmds;
@@ -90,10 +93,15 @@ namespace Core::Discord
         auto task = std::make_unique<Utils::TaskSlashCommand>();
         task->type = Utils::TaskType::SLASH_COMMAND;
         task->priority = Utils::TaskPriority::High;
+        // Already deferred above, so only the interaction token's lifetime bounds it
+        task->arrived_at = std::chrono::steady_clock::now();
+        task->deadline = task->arrived_at + SLASH_COMMAND_WINDOW;
         task->event = event;
         task->ctx = m_ctx;
 
-        m_taskManager->submit(std::move(task));
+        std::unique_ptr<Utils::Task> queued = std::move(task);
+        if (!m_taskManager->try_submit(queued))
+            event.edit_original_response(dpp::message("⏳ The bot is overloaded right now, please try again in a moment."));
     }
 
     void Bot::OnButtonClick(const dpp::button_click_t &event)
@@ -107,8 +115,12 @@ namespace Core::Discord
         task->priority = Utils::TaskPriority::High; // UI interactions should be snappy
         task->event = event;
         task->ctx = m_ctx;
+        task->response = std::make_shared<ComponentResponse>(event);
+        task->arrived_at = std::chrono::steady_clock::now();
+        task->deadline = task->arrived_at + COMPONENT_WINDOW;
 
-        m_taskManager->submit(std::move(task));
+        auto response = task->response;
+        SubmitComponentTask(std::move(task), std::move(response), event);
     }
 
     void Bot::OnSelectClick(const dpp::select_click_t &event)
@@ -118,7 +130,33 @@ namespace Core::Discord
         task->priority = Utils::TaskPriority::High;
         task->event = event;
         task->ctx = m_ctx;
+        task->response = std::make_shared<ComponentResponse>(event);
+        task->arrived_at = std::chrono::steady_clock::now();
+        task->deadline = task->arrived_at + COMPONENT_WINDOW;
+
+        auto response = task->response;
+        SubmitComponentTask(std::move(task), std::move(response), event);
+    }
+
+    void Bot::SubmitComponentTask(std::unique_ptr<Utils::Task> task, std::shared_ptr<ComponentResponse> response,
+                                  const dpp::interaction_create_t &event)
+    {
+        auto ackAt = task->arrived_at + COMPONENT_ACK_AFTER;
+        if (!m_taskManager->try_submit(task))
+        {
+            event.reply(dpp::message("⏳ The bot is overloaded right now, please try again in a moment.").set_flags(dpp::m_ephemeral));
+            return;
+        }
 
-        m_taskManager->submit(std::move(task));
+        // Watchdog: if the handler hasn't answered by then (backed-up queue, slow DB), acknowledge the
+        // click so it doesn't fail; the handler's update then arrives as an edit. Runs on the timer
+        // thread, so it fires even while every worker is busy.
+        m_taskManager->run_at(ackAt,
+                              [response, id = event.command.id]
+                              {
+                                  if (response->AcknowledgeIfPending())
+                                      std::cout << "[Bot] Interaction " << id << " not answered in time, sent a deferred acknowledgement"
+                                                << std::endl;
+                              });
     }
 } // namespace Core::Discord
\ No newline at end of file
@@ -21,5 +21,16 @@ namespace Core::Discord
         void OnButtonClick(const dpp::button_click_t &event); 
         void OnSelectClick(const dpp::select_click_t &event); 
         void RegisterCommands();
+        // Captures only the context: the timer may outlive this Bot during shutdown
+        static std::unique_ptr<Utils::Task> MakeTrackerSweep(std::shared_ptr<Utils::AppContext> ctx);
+
+        // Discord fails a button/select click that gets no response within 3 seconds; deferred slash
+        // commands stay answerable for the interaction token's 15 minutes
+        static constexpr std::chrono::milliseconds COMPONENT_WINDOW{3000};
+        static constexpr std::chrono::milliseconds COMPONENT_ACK_AFTER{2000}; // Leaves time for the ack itself to land
+        static constexpr std::chrono::minutes SLASH_COMMAND_WINDOW{15};
+
+        void SubmitComponentTask(std::unique_ptr<Utils::Task> task, std::shared_ptr<ComponentResponse> response,
+                                 const dpp::interaction_create_t &event);
     };
 } // namespace Core::Discord
\ No newline at end of file
@@ -0,0 +1,52 @@
+#include "server/discord/ComponentResponse.h"
+
+namespace Core::Discord
+{
+    void ComponentResponse::Update(const dpp::message &msg)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            switch (m_state)
+            {
+            case State::Pending:
+                m_state = State::Answered;
+                break;
+            case State::Acknowledging:
+                // An edit sent now could overtake the ack; send it once the ack is confirmed
+                m_pendingEdit = msg;
+                return;
+            case State::Acknowledged:
+                m_event.edit_original_response(msg);
+                return;
+            case State::Answered:
+                return;
+            }
+        }
+        m_event.reply(dpp::ir_update_message, msg);
+    }
+
+    bool ComponentResponse::AcknowledgeIfPending()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_state != State::Pending)
+                return false;
+            m_state = State::Acknowledging;
+        }
+        m_event.reply(dpp::ir_deferred_update_message, dpp::message(),
+                      [self = shared_from_this()](const dpp::confirmation_callback_t &) { self->OnAcknowledged(); });
+        return true;
+    }
+
+    void ComponentResponse::OnAcknowledged()
+    {
+        std::optional<dpp::message> edit;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_state = State::Acknowledged;
+            edit.swap(m_pendingEdit);
+        }
+        if (edit)
+            m_event.edit_original_response(*edit);
+    }
+} // namespace Core::Discord
@@ -0,0 +1,43 @@
+#pragma once
+#include <dpp/dpp.h>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+namespace Core::Discord
+{
+    /**
+     * @brief The first response to a button or select interaction, shared by the task handling it and
+     * the deadline watchdog. Discord fails the click unless something answers within 3 seconds, so
+     * whichever side comes first answers: the handler with its message update, or the watchdog with a
+     * deferred-update acknowledgement, after which the handler's update is sent as an edit instead.
+     */
+    class ComponentResponse : public std::enable_shared_from_this<ComponentResponse>
+    {
+    public:
+        explicit ComponentResponse(const dpp::interaction_create_t &event) : m_event(event) {}
+
+        /// @brief Replaces the message the component belongs to. Call once, from the handler.
+        void Update(const dpp::message &msg);
+
+        /// @brief Watchdog side: sends a deferred-update acknowledgement if nothing was sent yet.
+        /// @return true if it had to.
+        bool AcknowledgeIfPending();
+
+    private:
+        enum class State
+        {
+            Pending,        // Nothing sent
+            Acknowledging,  // Deferred ack sent, Discord hasn't confirmed it yet
+            Acknowledged,   // Deferred ack confirmed; updates go out as edits
+            Answered        // The handler's update was the response
+        };
+
+        void OnAcknowledged();
+
+        dpp::interaction_create_t m_event;
+        std::mutex m_mutex;
+        State m_state = State::Pending;
+        std::optional<dpp::message> m_pendingEdit; // Update that arrived while the ack was in flight
+    };
+} // namespace Core::Discord
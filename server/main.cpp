@@ -1,9 +1,14 @@
 #include "server/core/TaskManager.h"
 #include "server/database/Database.h"
+#include "server/database/WriteBehind.h"
 #include "server/discord/Bot.h"
 #include "server/riot/RiotClient.h"
+#include "server/tracker/PollSchedule.h"
+#include "server/tracker/TrackerPipeline.h"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
@@ -14,8 +19,22 @@ struct Config
     std::string application_id;
     std::string riot_key;
     std::string db_file;
+    int db_read_connections = 4;
+    bool db_write_behind = true;
+    Server::DB::WriteBehindOptions db_write_behind_options;
     int thread_count = 4;
+    std::string scheduler = "shared";
+    std::array<unsigned, 3> scheduler_weights = {1, 3, 8}; // Low, Standard, High
+    int scheduler_aging_ms = 30000;
+    int scheduler_stats_interval_s = 300;
+    int match_cache_mb = 16;
+    std::vector<Server::Riot::RateLimit> riot_rate_limits = {{20, std::chrono::seconds(1)}, {100, std::chrono::minutes(2)}};
+    std::array<size_t, 3> queue_capacity = {20000, 1000, 1000}; // Low, Standard, High (0 = unbounded)
+    std::string tracker_engine = "tasks";
+    Core::Tracker::TrackerPipelineOptions tracker_pipeline;
+    Core::Tracker::PollScheduleOptions poll_schedule;
     std::vector<Server::DB::ExerciseDefinition> exercises;
+    std::map<std::string, double> exercise_type_weights;
 };
 
 // Helper to load config
@@ -39,7 +58,69 @@ Config LoadConfig(const std::string &path)
         // Optional fields with defaults
         cfg.application_id = j.value("application_id", "");
         cfg.db_file = j.value("database_file", "league_fitness.db");
+        cfg.db_read_connections = std::max(0, j.value("database_read_connections", 4));
+        if (j.contains("database_write_behind"))
+        {
+            const auto &w = j["database_write_behind"];
+            if (w.is_boolean())
+                cfg.db_write_behind = w.get<bool>();
+            else if (w.is_object())
+            {
+                auto &opt = cfg.db_write_behind_options;
+                opt.batch_ops = w.value("batch_ops", opt.batch_ops);
+                opt.batch_window = std::chrono::milliseconds(w.value("batch_ms", static_cast<int>(opt.batch_window.count())));
+            }
+        }
         cfg.thread_count = j.value("thread_pool_size", 4);
+        cfg.scheduler = j.value("thread_pool_scheduler", "shared");
+        if (j.contains("scheduler_weights") && j["scheduler_weights"].is_object())
+        {
+            const auto &w = j["scheduler_weights"];
+            cfg.scheduler_weights = {w.value("low", 1u), w.value("standard", 3u), w.value("high", 8u)};
+        }
+        cfg.scheduler_aging_ms = j.value("scheduler_aging_ms", 30000);
+        cfg.scheduler_stats_interval_s = j.value("scheduler_stats_interval_s", 300);
+        cfg.match_cache_mb = j.value("match_cache_mb", 16);
+        if (j.contains("riot_rate_limits") && j["riot_rate_limits"].is_array())
+        {
+            cfg.riot_rate_limits.clear();
+            for (const auto &item : j["riot_rate_limits"])
+            {
+                int requests = item.value("requests", 0);
+                int seconds = item.value("seconds", 0);
+                if (requests > 0 && seconds > 0)
+                    cfg.riot_rate_limits.push_back({requests, std::chrono::seconds(seconds)});
+            }
+        }
+        if (j.contains("queue_capacity") && j["queue_capacity"].is_object())
+        {
+            const auto &c = j["queue_capacity"];
+            cfg.queue_capacity = {c.value("low", size_t(20000)), c.value("standard", size_t(1000)), c.value("high", size_t(1000))};
+        }
+        cfg.tracker_engine = j.value("tracker_engine", "tasks");
+        if (j.contains("tracker_pipeline") && j["tracker_pipeline"].is_object())
+        {
+            const auto &p = j["tracker_pipeline"];
+            auto &opt = cfg.tracker_pipeline;
+            opt.list_threads = p.value("list_threads", opt.list_threads);
+            opt.filter_threads = p.value("filter_threads", opt.filter_threads);
+            opt.detail_threads = p.value("detail_threads", opt.detail_threads);
+            opt.stats_threads = p.value("stats_threads", opt.stats_threads);
+            opt.persist_threads = p.value("persist_threads", opt.persist_threads);
+            opt.notify_threads = p.value("notify_threads", opt.notify_threads);
+            opt.queue_capacity = p.value("queue_capacity", opt.queue_capacity);
+        }
+        cfg.tracker_pipeline.stats_interval = std::chrono::seconds(cfg.scheduler_stats_interval_s);
+        if (j.contains("poll_schedule") && j["poll_schedule"].is_object())
+        {
+            const auto &p = j["poll_schedule"];
+            auto &opt = cfg.poll_schedule;
+            opt.min_interval = std::chrono::seconds(p.value("min_interval_s", (int64_t)opt.min_interval.count()));
+            opt.max_interval = std::chrono::seconds(p.value("max_interval_s", (int64_t)opt.max_interval.count()));
+            opt.backoff = p.value("backoff", opt.backoff);
+            opt.jitter = p.value("jitter", opt.jitter);
+            opt.tick = std::chrono::seconds(p.value("tick_s", (int64_t)opt.tick.count()));
+        }
 
         if (j.contains("exercises") && j["exercises"].is_array())
         {
@@ -53,6 +134,11 @@ Config LoadConfig(const std::string &path)
                 cfg.exercises.push_back(ex);
             }
         }
+        if (j.contains("exercise_type_weights") && j["exercise_type_weights"].is_object())
+        {
+            for (const auto &[type, weight] : j["exercise_type_weights"].items())
+                cfg.exercise_type_weights[type] = weight.get<double>();
+        }
     }
     catch (const json::exception &e)
     {
@@ -62,7 +148,7 @@ Config LoadConfig(const std::string &path)
     return cfg;
 }
 
-int main()
+int main(int argc, char **argv)
 {
     try
     {
@@ -70,6 +156,20 @@ int main()
         std::cout << "Loading configuration from LeagueOfGains.cfg..." << std::endl;
         Config cfg = LoadConfig("LeagueOfGains.cfg");
 
+        // Maintenance: recompute the /stats summary tables from the raw history, then exit
+        if (argc > 1 && std::string(argv[1]) == "--rebuild-stats")
+        {
+            Server::DB::Database db(cfg.db_file, 0);
+            std::cout << "Rebuilding user stats..." << std::endl;
+            if (!db.RebuildUserStats())
+            {
+                std::cerr << "Rebuild failed; the previous stats were kept." << std::endl;
+                return 1;
+            }
+            std::cout << "User stats rebuilt." << std::endl;
+            return 0;
+        }
+
         if (cfg.bot_token == "YOUR_DISCORD_BOT_TOKEN_HERE" || cfg.riot_key == "YOUR_RIOT_API_KEY_HERE")
         {
             std::cerr << "⚠️  Please update LeagueOfGains.cfg with your actual credentials." << std::endl;
@@ -81,23 +181,50 @@ int main()
         auto botCluster = std::make_shared<dpp::cluster>(cfg.bot_token);
 
         std::cout << "Initializing Database..." << std::endl;
-        auto db = std::make_shared<Server::DB::Database>(cfg.db_file);
+        auto db = std::make_shared<Server::DB::Database>(cfg.db_file, static_cast<size_t>(cfg.db_read_connections));
 
         // Seed exercises from config
-        db->SeedExercises(cfg.exercises);
+        db->SeedExercises(cfg.exercises, cfg.exercise_type_weights);
 
         std::cout << "Initializing Riot Client..." << std::endl;
-        auto riot = std::make_shared<Server::Riot::RiotClient>(botCluster, cfg.riot_key);
+        Server::Riot::RiotClientOptions riotOptions;
+        riotOptions.match_cache_bytes = static_cast<size_t>(std::max(0, cfg.match_cache_mb)) * 1024 * 1024;
+        riotOptions.rate_limits = cfg.riot_rate_limits;
+        auto riot = std::make_shared<Server::Riot::RiotClient>(botCluster, cfg.riot_key, riotOptions);
 
         // 3. Shared Context
         auto ctx = std::make_shared<Core::Utils::AppContext>();
         ctx->bot = botCluster;
         ctx->db = db;
+        if (cfg.db_write_behind)
+        {
+            cfg.db_write_behind_options.stats_interval = std::chrono::seconds(cfg.scheduler_stats_interval_s);
+            ctx->dbWriter = std::make_shared<Server::DB::WriteBehind>(db, cfg.db_write_behind_options);
+        }
         ctx->riot = riot;
+        ctx->userChecks = std::make_shared<Core::Utils::UserCheckRegistry>();
+        ctx->pollSchedule = std::make_shared<Core::Tracker::PollSchedule>(cfg.poll_schedule);
+        if (cfg.tracker_engine == "pipeline")
+        {
+            std::cout << "Starting pipelined tracker engine..." << std::endl;
+            ctx->tracker = std::make_shared<Core::Tracker::TrackerPipeline>(cfg.tracker_pipeline, botCluster, db, riot, ctx->pollSchedule);
+        }
+        else if (cfg.tracker_engine != "tasks")
+        {
+            std::cerr << "Unknown tracker_engine '" << cfg.tracker_engine << "', using 'tasks'" << std::endl;
+        }
 
         // 4. Task Manager
-        std::cout << "Starting Task Manager with " << cfg.thread_count << " threads..." << std::endl;
-        auto taskManager = std::make_shared<Core::Utils::TaskManager>(cfg.thread_count, ctx);
+        std::cout << "Starting Task Manager with " << cfg.thread_count << " threads (" << cfg.scheduler
+                  << " scheduler)..." << std::endl;
+        Core::Utils::TaskManagerOptions tmOptions;
+        tmOptions.num_threads = cfg.thread_count;
+        tmOptions.scheduler = Core::Utils::ParseSchedulerMode(cfg.scheduler);
+        tmOptions.weights = cfg.scheduler_weights;
+        tmOptions.aging_threshold = std::chrono::milliseconds(cfg.scheduler_aging_ms);
+        tmOptions.stats_interval = std::chrono::seconds(cfg.scheduler_stats_interval_s);
+        tmOptions.capacity = cfg.queue_capacity;
+        auto taskManager = std::make_shared<Core::Utils::TaskManager>(tmOptions, ctx);
 
         // 5. Bot Wrapper
         Core::Discord::Bot botApp;
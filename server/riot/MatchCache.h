@@ -0,0 +1,135 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Server::Riot
+{
+    // The handful of per-participant fields the tracker needs, kept for all ten players
+    struct ParticipantSummary
+    {
+        std::string puuid;
+        std::string champion_name;
+        int team_id = 0;
+        int kills = 0;
+        int deaths = 0;
+        int assists = 0;
+        int total_minions = 0;
+        int neutral_minions = 0;
+        bool win = false;
+    };
+
+    // Parsed /lol/match/v5/matches/{id} payload, reduced to what MatchStats is built from
+    struct MatchSummary
+    {
+        std::string match_id;
+        int64_t game_creation = 0;
+        int64_t game_duration = 0;
+        std::vector<ParticipantSummary> participants;
+
+        // Rough heap footprint, used to enforce the cache's memory budget
+        size_t ApproxBytes() const
+        {
+            size_t bytes = sizeof(MatchSummary) + match_id.capacity();
+            for (const auto &p : participants)
+                bytes += sizeof(ParticipantSummary) + p.puuid.capacity() + p.champion_name.capacity();
+            return bytes;
+        }
+    };
+
+    /**
+     * @brief Thread-safe LRU cache of parsed match summaries, keyed by match_id.
+     * A five-stack of tracked friends shares one download: the first AnalyzeMatch fills the cache
+     * and the other four are served from memory without touching the network or the rate limiter.
+     */
+    class MatchCache
+    {
+    public:
+        explicit MatchCache(size_t budget_bytes) : m_budget(budget_bytes) {}
+
+        std::shared_ptr<const MatchSummary> Get(const std::string &match_id)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_index.find(match_id);
+            if (it == m_index.end())
+            {
+                m_misses++;
+                LogStatsLocked();
+                return nullptr;
+            }
+
+            // Move to front (most recently used)
+            m_lru.splice(m_lru.begin(), m_lru, it->second);
+            m_hits++;
+            LogStatsLocked();
+            return it->second->summary;
+        }
+
+        void Put(std::shared_ptr<const MatchSummary> summary)
+        {
+            if (!summary || m_budget == 0)
+                return;
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_index.find(summary->match_id);
+            if (it != m_index.end())
+            {
+                m_bytes -= it->second->bytes;
+                m_lru.erase(it->second);
+                m_index.erase(it);
+            }
+
+            size_t bytes = summary->ApproxBytes();
+            m_lru.push_front({summary, bytes});
+            m_index[summary->match_id] = m_lru.begin();
+            m_bytes += bytes;
+
+            // Evict least recently used entries until we fit the budget again
+            while (m_bytes > m_budget && m_lru.size() > 1)
+            {
+                auto &victim = m_lru.back();
+                m_bytes -= victim.bytes;
+                m_index.erase(victim.summary->match_id);
+                m_lru.pop_back();
+                m_evictions++;
+            }
+        }
+
+        uint64_t Hits() const { return m_hits.load(); }
+        uint64_t Misses() const { return m_misses.load(); }
+        uint64_t Evictions() const { return m_evictions.load(); }
+
+    private:
+        struct Entry
+        {
+            std::shared_ptr<const MatchSummary> summary;
+            size_t bytes;
+        };
+
+        void LogStatsLocked()
+        {
+            uint64_t lookups = m_hits + m_misses;
+            if (lookups % 1000 != 0)
+                return;
+            std::cout << "[MatchCache] " << m_hits << " hits / " << m_misses << " misses (" << (m_hits * 100 / lookups)
+                      << "% hit rate), " << m_lru.size() << " matches, " << m_bytes / 1024 << " KiB of "
+                      << m_budget / 1024 << " KiB, " << m_evictions << " evictions" << std::endl;
+        }
+
+        std::mutex m_mutex;
+        std::list<Entry> m_lru;
+        std::unordered_map<std::string, std::list<Entry>::iterator> m_index;
+        size_t m_budget;
+        size_t m_bytes = 0;
+
+        std::atomic<uint64_t> m_hits{0};
+        std::atomic<uint64_t> m_misses{0};
+        std::atomic<uint64_t> m_evictions{0};
+    };
+} // namespace Server::Riot
@@ -0,0 +1,166 @@
+#include "server/riot/MatchParser.h"
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+namespace Server::Riot
+{
+    namespace
+    {
+        // SAX handler for nlohmann::json::sax_parse. Tracks which container we are in and only
+        // records scalars under root.info and root.info.participants[*]; nested containers we
+        // don't care about are entered as Skip frames and their contents ignored.
+        class MatchSummarySax
+        {
+        public:
+            using number_integer_t = nlohmann::json::number_integer_t;
+            using number_unsigned_t = nlohmann::json::number_unsigned_t;
+            using number_float_t = nlohmann::json::number_float_t;
+            using string_t = nlohmann::json::string_t;
+            using binary_t = nlohmann::json::binary_t;
+
+            explicit MatchSummarySax(MatchSummary &out) : m_out(out) { m_frames.reserve(16); }
+
+            bool null() { return true; }
+            bool boolean(bool val)
+            {
+                if (Top() == Frame::Participant && m_key == "win")
+                    m_out.participants.back().win = val;
+                return true;
+            }
+            bool number_integer(number_integer_t val) { return Integer(static_cast<int64_t>(val)); }
+            bool number_unsigned(number_unsigned_t val) { return Integer(static_cast<int64_t>(val)); }
+            bool number_float(number_float_t val, const string_t &) { return Integer(static_cast<int64_t>(val)); }
+            bool string(string_t &val)
+            {
+                if (Top() != Frame::Participant)
+                    return true;
+                if (m_key == "puuid")
+                    m_out.participants.back().puuid = std::move(val);
+                else if (m_key == "championName")
+                    m_out.participants.back().champion_name = std::move(val);
+                return true;
+            }
+            bool binary(binary_t &) { return true; }
+
+            bool start_object(std::size_t)
+            {
+                Frame parent = Top();
+                Frame next = Frame::Skip;
+                if (m_frames.empty())
+                    next = Frame::Root;
+                else if (parent == Frame::Root && m_key == "info")
+                {
+                    next = Frame::Info;
+                    m_sawInfo = true;
+                }
+                else if (parent == Frame::Participants)
+                {
+                    next = Frame::Participant;
+                    m_out.participants.emplace_back();
+                }
+                m_frames.push_back(next);
+                return true;
+            }
+            bool end_object() { return Pop(); }
+
+            bool start_array(std::size_t)
+            {
+                bool participants = Top() == Frame::Info && m_key == "participants";
+                m_frames.push_back(participants ? Frame::Participants : Frame::Skip);
+                return true;
+            }
+            bool end_array() { return Pop(); }
+
+            bool key(string_t &val)
+            {
+                // Keys inside skipped containers are irrelevant; don't bother copying them
+                if (Top() != Frame::Skip)
+                    m_key.assign(val);
+                return true;
+            }
+
+            bool parse_error(std::size_t position, const std::string &, const nlohmann::detail::exception &ex)
+            {
+                std::cerr << "JSON Parse Error in match " << m_out.match_id << " at byte " << position << ": " << ex.what()
+                          << std::endl;
+                return false;
+            }
+
+            bool SawInfo() const { return m_sawInfo; }
+
+        private:
+            enum class Frame
+            {
+                None,
+                Root,
+                Info,
+                Participants,
+                Participant,
+                Skip
+            };
+
+            Frame Top() const { return m_frames.empty() ? Frame::None : m_frames.back(); }
+
+            bool Pop()
+            {
+                m_frames.pop_back();
+                m_key.clear();
+                return true;
+            }
+
+            bool Integer(int64_t val)
+            {
+                Frame top = Top();
+                if (top == Frame::Info)
+                {
+                    if (m_key == "gameCreation")
+                        m_out.game_creation = val;
+                    else if (m_key == "gameDuration")
+                        m_out.game_duration = val;
+                }
+                else if (top == Frame::Participant)
+                {
+                    auto &p = m_out.participants.back();
+                    if (m_key == "teamId")
+                        p.team_id = static_cast<int>(val);
+                    else if (m_key == "kills")
+                        p.kills = static_cast<int>(val);
+                    else if (m_key == "deaths")
+                        p.deaths = static_cast<int>(val);
+                    else if (m_key == "assists")
+                        p.assists = static_cast<int>(val);
+                    else if (m_key == "totalMinionsKilled")
+                        p.total_minions = static_cast<int>(val);
+                    else if (m_key == "neutralMinionsKilled")
+                        p.neutral_minions = static_cast<int>(val);
+                }
+                return true;
+            }
+
+            MatchSummary &m_out;
+            std::vector<Frame> m_frames;
+            std::string m_key;
+            bool m_sawInfo = false;
+        };
+    } // namespace
+
+    std::shared_ptr<MatchSummary> ParseMatchSummary(const std::string &match_id, const std::string &body)
+    {
+        auto summary = std::make_shared<MatchSummary>();
+        summary->match_id = match_id;
+        summary->participants.reserve(10);
+
+        MatchSummarySax handler(*summary);
+        if (!nlohmann::json::sax_parse(body, &handler) || !handler.SawInfo())
+            return nullptr;
+
+        // Unknown fields keep their defaults, matching the old .value() fallbacks
+        for (auto &p : summary->participants)
+        {
+            if (p.champion_name.empty())
+                p.champion_name = "Unknown";
+        }
+        return summary;
+    }
+} // namespace Server::Riot
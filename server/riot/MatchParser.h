@@ -0,0 +1,16 @@
+#pragma once
+#include "server/riot/MatchCache.h"
+#include <memory>
+#include <string>
+
+namespace Server::Riot
+{
+    /**
+     * @brief Extracts a MatchSummary from a raw /lol/match/v5/matches/{id} response body.
+     * Streams the payload through a SAX handler that only materialises info.gameCreation,
+     * info.gameDuration and the MatchSummary fields of each participant. Everything else
+     * (challenges, perks, timeline-ish blobs) is skipped without building a DOM.
+     * @return The summary, or nullptr if the body is not valid JSON or has no "info" object.
+     */
+    std::shared_ptr<MatchSummary> ParseMatchSummary(const std::string &match_id, const std::string &body);
+} // namespace Server::Riot
@@ -1,23 +1,71 @@
 #pragma once
+#include <algorithm>
 #include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <iostream>
 #include <mutex>
+#include <sstream>
+#include <string>
 #include <thread>
+#include <vector>
 
 namespace Server::Riot
 {
+    // One "N requests per window" rule, e.g. Riot's development key allows 20 / 1 s AND 100 / 2 min.
+    struct RateLimit
+    {
+        int requests;
+        std::chrono::milliseconds window;
+
+        bool operator==(const RateLimit &other) const { return requests == other.requests && window == other.window; }
+    };
+
+    // Parses Riot's "20:1,100:120" header format (X-App-Rate-Limit, X-Method-Rate-Limit and their -Count
+    // variants) into {requests, window} pairs. For -Count headers `requests` holds the current count.
+    inline std::vector<RateLimit> ParseRateLimitHeader(const std::string &value)
+    {
+        std::vector<RateLimit> limits;
+        std::stringstream ss(value);
+        std::string item;
+        while (std::getline(ss, item, ','))
+        {
+            auto colon = item.find(':');
+            if (colon == std::string::npos)
+                continue;
+            try
+            {
+                int requests = std::stoi(item.substr(0, colon));
+                int seconds = std::stoi(item.substr(colon + 1));
+                if (requests >= 0 && seconds > 0)
+                    limits.push_back({requests, std::chrono::seconds(seconds)});
+            }
+            catch (...)
+            {
+                // Malformed entry; ignore it rather than trusting a partial limit
+            }
+        }
+        return limits;
+    }
+
     /**
-     * @brief A thread-safe Token Bucket Rate Limiter.
-     * Prevents the bot from exceeding Riot API limits (e.g., 20 req / 1 sec, 100 req / 2 min).
+     * @brief A thread-safe multi-window sliding-log Rate Limiter.
+     * Enforces every configured window at once (e.g. 20 req / 1 sec AND 100 req / 2 min).
+     * Each window keeps the send times of its last `requests` grants, so a request is allowed as soon
+     * as the oldest of them slides out of the window. This never exceeds any limit over *any* interval
+     * of that length (which also satisfies Riot's fixed windows) while still allowing full bursts.
+     * Limits, counts and Retry-After pauses can be updated at runtime from Riot's response headers.
      */
     class RateLimiter
     {
     public:
-        RateLimiter(int max_tokens, int refill_duration_ms)
-            : m_max_tokens(max_tokens), m_tokens(max_tokens), m_refill_duration(refill_duration_ms)
+        explicit RateLimiter(const std::vector<RateLimit> &limits, std::string name = "app") : m_name(std::move(name))
         {
-            m_last_refill = std::chrono::steady_clock::now();
+            for (const auto &limit : limits)
+            {
+                if (limit.requests > 0 && limit.window.count() > 0)
+                    m_windows.push_back({limit, {}});
+            }
         }
 
         void Wait()
@@ -26,51 +74,130 @@ namespace Server::Riot
 
             while (true)
             {
-                RefillTokens();
+                auto now = std::chrono::steady_clock::now();
+                auto readyAt = NextSlot(now);
 
-                if (m_tokens > 0)
+                if (readyAt <= now)
                 {
-                    m_tokens--;
+                    for (auto &w : m_windows)
+                        w.sent.push_back(now);
                     return;
                 }
 
-                // Calculate time to next refill to sleep efficiently
-                auto now = std::chrono::steady_clock::now();
-                auto time_since_refill = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_last_refill);
-                auto time_to_wait = m_refill_duration - time_since_refill;
+                // Sleep until the blocking window frees a slot
+                // We log this because it implies we are hitting capacity
+                auto time_to_wait = std::chrono::duration_cast<std::chrono::milliseconds>(readyAt - now);
+                std::cout << "[RateLimiter] " << m_name << ": throttling request for " << time_to_wait.count() << "ms..." << std::endl;
+                m_cv.wait_until(lock, readyAt);
+            }
+        }
+
+        /// @brief Earliest time a request may be sent (`now`, if every window has a slot). Never blocks.
+        std::chrono::steady_clock::time_point ReadyAt(std::chrono::steady_clock::time_point now)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return NextSlot(now);
+        }
+
+        /// @brief Records a request sent now without waiting. Pair with ReadyAt() when a single
+        /// dispatcher thread sends on behalf of many callers.
+        void Record()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto now = std::chrono::steady_clock::now();
+            for (auto &w : m_windows)
+                w.sent.push_back(now);
+        }
+
+        /// @brief Replaces the enforced windows, e.g. with the limits Riot reports for this key.
+        /// Windows whose length is unchanged keep their send history. No-op if nothing changed.
+        void UpdateLimits(const std::vector<RateLimit> &limits)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            std::vector<RateLimit> current;
+            for (const auto &w : m_windows)
+                current.push_back(w.limit);
+            if (current == limits)
+                return;
 
-                if (time_to_wait.count() > 0)
+            std::vector<Window> windows;
+            for (const auto &limit : limits)
+            {
+                if (limit.requests <= 0 || limit.window.count() <= 0)
+                    continue;
+                Window w{limit, {}};
+                for (auto &old : m_windows)
                 {
-                    // Wait for condition variable or timeout
-                    // We log this because it implies we are hitting capacity
-                    std::cout << "[RateLimiter] Throttling request for " << time_to_wait.count() << "ms..." << std::endl;
-                    m_cv.wait_for(lock, time_to_wait);
+                    if (old.limit.window == limit.window)
+                        w.sent = std::move(old.sent);
                 }
+                windows.push_back(std::move(w));
             }
+            m_windows = std::move(windows);
+
+            std::cout << "[RateLimiter] " << m_name << ": limits now";
+            for (const auto &w : m_windows)
+                std::cout << " " << w.limit.requests << "/" << w.limit.window.count() / 1000 << "s";
+            std::cout << std::endl;
+            m_cv.notify_all();
         }
 
-    private:
-        void RefillTokens()
+        /// @brief Reconciles with the server's view of a window ("X-...-Count").
+        /// If Riot has counted more requests than we have (restart, another process sharing the key),
+        /// the difference is recorded as sent now so we back off instead of drawing 429s.
+        void SyncCount(std::chrono::milliseconds window, int count)
         {
+            std::lock_guard<std::mutex> lock(m_mutex);
             auto now = std::chrono::steady_clock::now();
-            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_last_refill);
+            for (auto &w : m_windows)
+            {
+                if (w.limit.window != window)
+                    continue;
+                while (!w.sent.empty() && w.sent.front() + w.limit.window <= now)
+                    w.sent.pop_front();
+                while (static_cast<int>(w.sent.size()) < std::min(count, w.limit.requests))
+                    w.sent.push_back(now);
+            }
+        }
+
+        /// @brief Blocks every Wait() until `until` (Riot's Retry-After).
+        void PauseUntil(std::chrono::steady_clock::time_point until)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pausedUntil = std::max(m_pausedUntil, until);
+        }
 
-            if (duration >= m_refill_duration)
+    private:
+        struct Window
+        {
+            RateLimit limit;
+            std::deque<std::chrono::steady_clock::time_point> sent;
+        };
+
+        // Earliest time every window has a free slot. Drops send times that have left their window.
+        std::chrono::steady_clock::time_point NextSlot(std::chrono::steady_clock::time_point now)
+        {
+            auto readyAt = std::max(now, m_pausedUntil);
+            for (auto &w : m_windows)
             {
-                // Logic: How many intervals passed?
-                // For simplicity in this specific bucket type, if the duration passed, we reset full tokens.
-                // A more complex sliding window could be used, but this is sufficient for Riot's short burst windows.
-                m_tokens = m_max_tokens;
-                m_last_refill = now;
-                m_cv.notify_all();
+                while (!w.sent.empty() && w.sent.front() + w.limit.window <= now)
+                    w.sent.pop_front();
+
+                if (static_cast<int>(w.sent.size()) >= w.limit.requests)
+                {
+                    // The slot frees up when the grant `requests` positions back expires
+                    auto oldest = w.sent[w.sent.size() - w.limit.requests];
+                    readyAt = std::max(readyAt, oldest + w.limit.window);
+                }
             }
+            return readyAt;
         }
 
         std::mutex m_mutex;
         std::condition_variable m_cv;
-        int m_max_tokens;
-        int m_tokens;
-        std::chrono::milliseconds m_refill_duration;
-        std::chrono::steady_clock::time_point m_last_refill;
+        std::vector<Window> m_windows;
+        std::chrono::steady_clock::time_point m_pausedUntil{};
+        std::string m_name;
     };
-} // namespace Server::Riot
\ No newline at end of file
+} // namespace Server::Riot
@@ -1,21 +1,75 @@
 #include "server/riot/RiotClient.h"
+#include "server/riot/MatchParser.h"
+#include <algorithm>
+#include <cctype>
 #include <cmath>
-#include <future>
 #include <iostream>
-#include <thread>
 
 namespace Server::Riot
 {
+    namespace
+    {
+        // Header lookup that doesn't depend on how the HTTP client cased the names
+        std::optional<std::string> Header(const dpp::http_request_completion_t &response, const std::string &name)
+        {
+            for (const auto &[key, value] : response.headers)
+            {
+                if (key.size() == name.size() &&
+                    std::equal(key.begin(), key.end(), name.begin(),
+                               [](char a, char b) { return std::tolower((unsigned char)a) == std::tolower((unsigned char)b); }))
+                    return value;
+            }
+            return std::nullopt;
+        }
+    } // namespace
+
     // Initialize Rate Limiters
-    // App Rate Limit: 20 requests every 1 second AND 100 requests every 2 minutes.
-    // We choose the tighter constraint for safety: 100 req / 120000ms ~ 0.833 req / 1000ms.
-    // We can also chain them, but a single strict bucket usually suffices for small bots.
-    RiotClient::RiotClient(std::shared_ptr<dpp::cluster> bot, const std::string &apiKey)
-        : m_bot(bot), m_apiKey(apiKey), m_limiter(std::make_unique<RateLimiter>(20, 25000)) // 20req/25sec to be safe
+    // App Rate Limit: every configured window is enforced at once (development keys: 20 requests every
+    // 1 second AND 100 requests every 2 minutes), so bursts use the short window and sustained load the long one.
+    // These are only the starting point; each routing value adopts the limits Riot reports for the key.
+    RiotClient::RiotClient(std::shared_ptr<dpp::cluster> bot, const std::string &apiKey, const RiotClientOptions &options)
+        : m_bot(bot), m_apiKey(apiKey), m_defaultAppLimits(options.rate_limits), m_matchCache(options.match_cache_bytes)
     {
         m_routing = {{"na1", "americas"}, {"br1", "americas"}, {"la1", "americas"}, {"la2", "americas"},
                      {"euw1", "europe"},  {"eun1", "europe"},  {"tr1", "europe"},   {"ru", "europe"},
                      {"kr", "asia"},      {"jp1", "asia"},     {"oc1", "sea"}};
+
+        m_lifeline = std::make_shared<Lifeline>();
+        m_lifeline->client = this;
+        m_dispatcher = std::thread(&RiotClient::DispatchLoop, this);
+    }
+
+    RiotClient::~RiotClient()
+    {
+        // Responses arriving from now on are dropped; the requests they belong to are completed below
+        {
+            std::unique_lock<std::shared_mutex> lock(m_lifeline->mutex);
+            m_lifeline->client = nullptr;
+        }
+
+        std::deque<PendingRequest> abandoned;
+        {
+            std::lock_guard<std::mutex> lock(m_dispatchMutex);
+            m_stopping = true;
+            abandoned.swap(m_pending);
+        }
+        m_dispatchCv.notify_all();
+        if (m_dispatcher.joinable())
+            m_dispatcher.join();
+
+        // Don't leave blocking callers or suspended coroutines waiting forever
+        std::vector<std::shared_ptr<InFlightRequest>> inFlight;
+        {
+            std::lock_guard<std::mutex> lock(m_dispatchMutex);
+            inFlight.swap(m_inFlight);
+        }
+        for (auto &request : abandoned)
+            Complete(request, std::nullopt);
+        for (auto &flight : inFlight)
+        {
+            if (!flight->finished.exchange(true))
+                Complete(flight->request, std::nullopt);
+        }
     }
 
     std::string RiotClient::GetRoute(const std::string &region)
@@ -24,173 +78,455 @@ namespace Server::Riot
         return (it != m_routing.end()) ? it->second : "americas";
     }
 
-    nlohmann::json RiotClient::Request(const std::string &url)
+    RateLimiter &RiotClient::AppLimiter(const std::string &route)
     {
-        if (!m_bot)
-            return nullptr;
+        std::lock_guard<std::mutex> lock(m_limiterMutex);
+        auto &limiter = m_appLimiters[route];
+        if (!limiter)
+            limiter = std::make_unique<RateLimiter>(m_defaultAppLimits, route + " app");
+        return *limiter;
+    }
 
-        int retries = 0;
-        const int MAX_RETRIES = 3;
+    RateLimiter &RiotClient::MethodLimiter(const std::string &route, const std::string &method)
+    {
+        // Method limits are unknown until the first response for the endpoint tells us
+        std::lock_guard<std::mutex> lock(m_limiterMutex);
+        auto &limiter = m_methodLimiters[route + " " + method];
+        if (!limiter)
+            limiter = std::make_unique<RateLimiter>(std::vector<RateLimit>{}, route + " " + method);
+        return *limiter;
+    }
 
-        while (retries < MAX_RETRIES)
+    void RiotClient::ApplyRateLimitHeaders(RateLimiter &app, RateLimiter &method, const dpp::http_request_completion_t &response)
+    {
+        if (auto limits = Header(response, "X-App-Rate-Limit"))
+            app.UpdateLimits(ParseRateLimitHeader(*limits));
+        if (auto counts = Header(response, "X-App-Rate-Limit-Count"))
         {
-            // Block until token is available
-            m_limiter->Wait();
+            for (const auto &c : ParseRateLimitHeader(*counts))
+                app.SyncCount(c.window, c.requests);
+        }
 
-            // 1. Prepare URL
-            std::string clean_url = url;
-            if (clean_url.substr(0, 8) == "https://")
-            {
-                clean_url = clean_url.substr(8);
-            }
-            else if (clean_url.substr(0, 7) == "http://")
+        if (auto limits = Header(response, "X-Method-Rate-Limit"))
+            method.UpdateLimits(ParseRateLimitHeader(*limits));
+        if (auto counts = Header(response, "X-Method-Rate-Limit-Count"))
+        {
+            for (const auto &c : ParseRateLimitHeader(*counts))
+                method.SyncCount(c.window, c.requests);
+        }
+    }
+
+    // -------------------------------------------------------------------------
+    // REQUEST DISPATCH
+    // -------------------------------------------------------------------------
+    void RiotClient::RequestBodyAsync(const std::string &route, const std::string &method, const std::string &url,
+                                      Callback<std::optional<std::string>> done)
+    {
+        PendingRequest request{route, method, url, 0, std::move(done)};
+        {
+            std::lock_guard<std::mutex> lock(m_dispatchMutex);
+            if (m_bot && !m_stopping)
             {
-                clean_url = clean_url.substr(7);
+                m_pending.push_back(std::move(request));
+                m_dispatchCv.notify_one();
+                return;
             }
+        }
+        Complete(request, std::nullopt);
+    }
 
-            // 2. Prepare Headers
-            std::multimap<std::string, std::string> headers;
-            headers.emplace("X-Riot-Token", m_apiKey);
+    void RiotClient::RequestJsonAsync(const std::string &route, const std::string &method, const std::string &url,
+                                      Callback<nlohmann::json> done)
+    {
+        RequestBodyAsync(route, method, url,
+                         [url, done = std::move(done)](std::optional<std::string> body)
+                         {
+                             if (!body)
+                             {
+                                 done(nullptr);
+                                 return;
+                             }
 
-            // 3. Sync Execution Wrapper
-            auto promise = std::make_shared<std::promise<dpp::http_request_completion_t>>();
-            auto future = promise->get_future();
+                             nlohmann::json json;
+                             try
+                             {
+                                 json = nlohmann::json::parse(*body);
+                             }
+                             catch (...)
+                             {
+                                 std::cerr << "JSON Parse Error for " << url << std::endl;
+                                 json = nullptr;
+                             }
+                             done(std::move(json));
+                         });
+    }
 
-            m_bot->request(
-                url, dpp::m_get, [promise](const dpp::http_request_completion_t &cc) { promise->set_value(cc); }, "",
-                "application/json", headers);
+    void RiotClient::DispatchLoop()
+    {
+        std::unique_lock<std::mutex> lock(m_dispatchMutex);
+        while (!m_stopping)
+        {
+            auto now = std::chrono::steady_clock::now();
+            auto wakeAt = std::chrono::steady_clock::time_point::max();
+            std::vector<std::shared_ptr<InFlightRequest>> expired;
+            std::vector<PendingRequest> ready;
 
-            if (future.wait_for(std::chrono::seconds(5)) == std::future_status::timeout)
+            // 1. Time out requests whose response never arrived
+            for (auto it = m_inFlight.begin(); it != m_inFlight.end();)
             {
-                std::cerr << "Riot API Timeout: " << url << std::endl;
-                return nullptr;
+                auto &flight = *it;
+                if (flight->finished)
+                {
+                    it = m_inFlight.erase(it);
+                }
+                else if (flight->deadline <= now)
+                {
+                    if (!flight->finished.exchange(true))
+                        expired.push_back(flight);
+                    it = m_inFlight.erase(it);
+                }
+                else
+                {
+                    wakeAt = std::min(wakeAt, flight->deadline);
+                    ++it;
+                }
             }
 
-            auto response = future.get();
+            // 2. Release every queued request whose limiters have a slot. A saturated endpoint or
+            //    region doesn't hold up requests queued behind it for other ones.
+            for (auto it = m_pending.begin(); it != m_pending.end();)
+            {
+                RateLimiter &app = AppLimiter(it->route);
+                RateLimiter &method = MethodLimiter(it->route, it->method);
+                auto readyAt = std::max(app.ReadyAt(now), method.ReadyAt(now));
+                if (readyAt <= now)
+                {
+                    app.Record();
+                    method.Record();
+                    ready.push_back(std::move(*it));
+                    it = m_pending.erase(it);
+                }
+                else
+                {
+                    wakeAt = std::min(wakeAt, readyAt);
+                    ++it;
+                }
+            }
 
-            // Handle Rate Limits (429) specifically
-            if (response.status == 429)
+            if (expired.empty() && ready.empty())
             {
-                std::cerr << "⚠️ 429 HIT from Riot. Local limiter failed. Backing off..." << std::endl;
-                std::this_thread::sleep_for(std::chrono::seconds(2 * (retries + 1)));
-                retries++;
+                if (!m_pending.empty() && wakeAt - now >= std::chrono::seconds(1))
+                {
+                    // We log this because it implies we are hitting capacity
+                    std::cout << "[RiotClient] " << m_pending.size() << " requests throttled for "
+                              << std::chrono::duration_cast<std::chrono::milliseconds>(wakeAt - now).count() << "ms..."
+                              << std::endl;
+                }
+
+                if (wakeAt == std::chrono::steady_clock::time_point::max())
+                    m_dispatchCv.wait(lock);
+                else
+                    m_dispatchCv.wait_until(lock, wakeAt);
                 continue;
             }
 
-            if (response.status == 200)
+            lock.unlock();
+            for (auto &flight : expired)
+            {
+                std::cerr << "Riot API Timeout: " << flight->request.url << std::endl;
+                Complete(flight->request, std::nullopt);
+            }
+            for (auto &request : ready)
+                Send(std::move(request));
+            lock.lock();
+        }
+    }
+
+    void RiotClient::Send(PendingRequest request)
+    {
+        auto flight = std::make_shared<InFlightRequest>();
+        flight->request = std::move(request);
+        flight->deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        {
+            std::lock_guard<std::mutex> lock(m_dispatchMutex);
+            m_inFlight.push_back(flight);
+        }
+
+        std::multimap<std::string, std::string> headers;
+        headers.emplace("X-Riot-Token", m_apiKey);
+
+        m_bot->request(
+            flight->request.url, dpp::m_get,
+            [lifeline = m_lifeline, flight](const dpp::http_request_completion_t &cc)
+            {
+                std::shared_lock<std::shared_mutex> lock(lifeline->mutex);
+                if (lifeline->client)
+                    lifeline->client->OnResponse(flight, cc);
+            },
+            "", "application/json", headers);
+    }
+
+    void RiotClient::OnResponse(const std::shared_ptr<InFlightRequest> &flight, const dpp::http_request_completion_t &response)
+    {
+        if (flight->finished.exchange(true))
+            return; // Already timed out and reported
+
+        auto &request = flight->request;
+        RateLimiter &appLimiter = AppLimiter(request.route);
+        RateLimiter &methodLimiter = MethodLimiter(request.route, request.method);
+        ApplyRateLimitHeaders(appLimiter, methodLimiter, response);
+
+        // Handle Rate Limits (429) specifically
+        if (response.status == 429)
+        {
+            // Riot tells us exactly how long to back off and which limit tripped. Service-level 429s
+            // (shared Riot capacity) may omit Retry-After; pause that endpoint briefly instead.
+            int retryAfter = 1;
+            if (auto header = Header(response, "Retry-After"))
             {
                 try
                 {
-                    return nlohmann::json::parse(response.body);
+                    retryAfter = std::max(1, std::stoi(*header));
                 }
                 catch (...)
                 {
-                    std::cerr << "JSON Parse Error for " << url << std::endl;
-                    return nullptr;
+                    // Unparseable; keep the 1s default
                 }
             }
+            std::string type = Header(response, "X-Rate-Limit-Type").value_or("service");
 
-            std::cerr << "Riot API Error " << response.status << ": " << url << std::endl;
-            return nullptr;
+            std::cerr << "⚠️ 429 HIT from Riot (" << type << " limit, " << request.route << " " << request.method
+                      << "). Retrying in " << retryAfter << "s..." << std::endl;
+            auto until = std::chrono::steady_clock::now() + std::chrono::seconds(retryAfter);
+            (type == "application" ? appLimiter : methodLimiter).PauseUntil(until);
+
+            const int MAX_RETRIES = 3;
+            if (++request.attempt < MAX_RETRIES)
+            {
+                std::lock_guard<std::mutex> lock(m_dispatchMutex);
+                if (!m_stopping)
+                {
+                    // Back to the front: it has waited longest
+                    m_pending.push_front(std::move(request));
+                    m_dispatchCv.notify_one();
+                    return;
+                }
+            }
+            Complete(request, std::nullopt);
+            return;
         }
-        return nullptr;
+
+        if (response.status == 200)
+        {
+            Complete(request, response.body);
+            return;
+        }
+
+        std::cerr << "Riot API Error " << response.status << ": " << request.url << std::endl;
+        Complete(request, std::nullopt);
     }
 
-    std::tuple<std::string, std::string, std::string> RiotClient::GetAccount(const std::string &name, const std::string &tag,
-                                                                             const std::string &region)
+    void RiotClient::Complete(PendingRequest &request, std::optional<std::string> body)
+    {
+        // Callbacks run on D++ / dispatcher threads; an escaping exception would take those down
+        try
+        {
+            request.done(std::move(body));
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "[RiotClient] Callback for " << request.url << " threw: " << e.what() << std::endl;
+        }
+        catch (...)
+        {
+            std::cerr << "[RiotClient] Callback for " << request.url << " threw an unknown exception" << std::endl;
+        }
+    }
+
+    // -------------------------------------------------------------------------
+    // ENDPOINTS
+    // -------------------------------------------------------------------------
+    void RiotClient::GetAccountAsync(const std::string &name, const std::string &tag, const std::string &region,
+                                     Callback<std::tuple<std::string, std::string, std::string>> done)
     {
         std::string route = GetRoute(region);
         std::string encodedName = dpp::utility::url_encode(name);
         std::string url =
             "https://" + route + ".api.riotgames.com/riot/account/v1/accounts/by-riot-id/" + encodedName + "/" + tag;
 
-        auto json = Request(url);
-        if (!json.is_null() && json.contains("puuid"))
-        {
-            return {json.value("puuid", ""), json.value("gameName", ""), json.value("tagLine", "")};
-        }
-        return {};
+        RequestJsonAsync(route, "account-v1.by-riot-id", url,
+                         [done = std::move(done)](nlohmann::json json)
+                         {
+                             if (!json.is_null() && json.contains("puuid"))
+                             {
+                                 done({json.value("puuid", ""), json.value("gameName", ""), json.value("tagLine", "")});
+                                 return;
+                             }
+                             done({});
+                         });
     }
 
-    std::vector<std::string> RiotClient::GetLastMatches(const std::string &puuid, const std::string &region, int count)
+    void RiotClient::GetLastMatchesAsync(const std::string &puuid, const std::string &region, const MatchListQuery &query,
+                                         Callback<std::optional<std::vector<std::string>>> done)
     {
         std::string route = GetRoute(region);
         std::string url = "https://" + route + ".api.riotgames.com/lol/match/v5/matches/by-puuid/" + puuid +
-                          "/ids?start=0&count=" + std::to_string(count);
+                          "/ids?start=" + std::to_string(query.start) + "&count=" + std::to_string(query.count);
+        if (query.start_time > 0)
+            url += "&startTime=" + std::to_string(query.start_time);
+
+        RequestJsonAsync(route, "match-v5.ids-by-puuid", url,
+                         [done = std::move(done)](nlohmann::json json)
+                         {
+                             // Anything but an array of ids (failed request, unparseable body) is a failure,
+                             // so callers never mistake it for an account without new games
+                             std::optional<std::vector<std::string>> matches;
+                             if (json.is_array())
+                             {
+                                 try
+                                 {
+                                     matches = json.get<std::vector<std::string>>();
+                                 }
+                                 catch (...)
+                                 {
+                                     matches.reset();
+                                 }
+                             }
+                             done(std::move(matches));
+                         });
+    }
+
+    void RiotClient::GetMatchSummaryAsync(const std::string &match_id, const std::string &region,
+                                          Callback<std::shared_ptr<const MatchSummary>> done)
+    {
+        if (auto cached = m_matchCache.Get(match_id))
+        {
+            done(cached);
+            return;
+        }
 
-        auto json = Request(url);
-        if (json.is_array())
+        // Single-flight: the first caller downloads, concurrent callers are queued behind its result
         {
-            return json.get<std::vector<std::string>>();
+            std::lock_guard<std::mutex> lock(m_loadingMutex);
+            auto it = m_loading.find(match_id);
+            if (it != m_loading.end())
+            {
+                it->second.push_back(std::move(done));
+                return;
+            }
+            m_loading[match_id].push_back(std::move(done));
         }
-        return {};
+
+        std::string route = GetRoute(region);
+        std::string url = "https://" + route + ".api.riotgames.com/lol/match/v5/matches/" + match_id;
+
+        // Match payloads are large; stream out just the fields we keep instead of building a DOM
+        RequestBodyAsync(route, "match-v5.match", url,
+                         [this, match_id](std::optional<std::string> body)
+                         {
+                             std::shared_ptr<const MatchSummary> summary;
+                             if (body)
+                             {
+                                 try
+                                 {
+                                     summary = ParseMatchSummary(match_id, *body);
+                                 }
+                                 catch (...)
+                                 {
+                                     summary = nullptr;
+                                 }
+                             }
+                             m_matchCache.Put(summary);
+
+                             std::vector<Callback<std::shared_ptr<const MatchSummary>>> waiters;
+                             {
+                                 std::lock_guard<std::mutex> lock(m_loadingMutex);
+                                 auto it = m_loading.find(match_id);
+                                 if (it != m_loading.end())
+                                 {
+                                     waiters = std::move(it->second);
+                                     m_loading.erase(it);
+                                 }
+                             }
+                             for (auto &waiter : waiters)
+                                 waiter(summary);
+                         });
+    }
+
+    void RiotClient::AnalyzeMatchAsync(const std::string &match_id, const std::string &puuid, const std::string &region,
+                                       Callback<MatchStats> done)
+    {
+        GetMatchSummaryAsync(match_id, region,
+                             [puuid, done = std::move(done)](std::shared_ptr<const MatchSummary> summary)
+                             { done(summary ? StatsFor(*summary, puuid) : MatchStats{}); });
+    }
+
+    std::tuple<std::string, std::string, std::string> RiotClient::GetAccount(const std::string &name, const std::string &tag,
+                                                                             const std::string &region)
+    {
+        return Await<std::tuple<std::string, std::string, std::string>>(
+            [&](auto done) { GetAccountAsync(name, tag, region, std::move(done)); });
+    }
+
+    std::optional<std::vector<std::string>> RiotClient::GetLastMatches(const std::string &puuid, const std::string &region,
+                                                                       int count)
+    {
+        MatchListQuery query;
+        query.count = count;
+        return GetLastMatches(puuid, region, query);
+    }
+
+    std::optional<std::vector<std::string>> RiotClient::GetLastMatches(const std::string &puuid, const std::string &region,
+                                                                       const MatchListQuery &query)
+    {
+        return Await<std::optional<std::vector<std::string>>>(
+            [&](auto done) { GetLastMatchesAsync(puuid, region, query, std::move(done)); });
+    }
+
+    std::shared_ptr<const MatchSummary> RiotClient::GetMatchSummary(const std::string &match_id, const std::string &region)
+    {
+        return Await<std::shared_ptr<const MatchSummary>>(
+            [&](auto done) { GetMatchSummaryAsync(match_id, region, std::move(done)); });
     }
 
     MatchStats RiotClient::AnalyzeMatch(const std::string &match_id, const std::string &puuid, const std::string &region)
     {
-        MatchStats stats;
-        std::string route = GetRoute(region);
-        std::string url = "https://" + route + ".api.riotgames.com/lol/match/v5/matches/" + match_id;
+        return Await<MatchStats>([&](auto done) { AnalyzeMatchAsync(match_id, puuid, region, std::move(done)); });
+    }
 
-        auto json = Request(url);
-        if (json.is_null() || !json.contains("info"))
+    MatchStats RiotClient::StatsFor(const MatchSummary &summary, const std::string &puuid)
+    {
+        MatchStats stats;
+        auto userP = std::find_if(summary.participants.begin(), summary.participants.end(),
+                                  [&](const ParticipantSummary &p) { return p.puuid == puuid; });
+        if (userP == summary.participants.end())
             return stats;
 
-        try
+        // Calculate team kills separately after finding teamId
+        int teamKills = 0;
+        for (const auto &p : summary.participants)
         {
-            auto info = json["info"];
-            auto participants = info["participants"];
-            long gameDuration = info.value("gameDuration", 0L);
+            if (p.team_id == userP->team_id)
+                teamKills += p.kills;
+        }
 
-            nlohmann::json userP;
-            int teamId = 0;
-            bool found = false;
-            int teamKills = 0;
+        int64_t gameDuration = summary.game_duration;
 
-            for (const auto &p : participants)
-            {
-                if (p.value("puuid", "") == puuid)
-                {
-                    userP = p;
-                    teamId = p.value("teamId", 0);
-                    found = true;
-                }
-            }
+        stats.valid = true;
+        stats.champion_name = userP->champion_name;
+        stats.kills = userP->kills;
+        stats.deaths = userP->deaths;
+        stats.assists = userP->assists;
+        stats.win = userP->win;
+        stats.timestamp = summary.game_creation;
+        stats.gameDuration = gameDuration;
 
-            if (found)
-            {
-                // Calculate team kills separately after finding teamId
-                for (const auto &p : participants)
-                {
-                    if (p.value("teamId", 0) == teamId)
-                        teamKills += p.value("kills", 0);
-                }
+        int involvement = stats.kills + stats.assists;
+        stats.kp_percent = (teamKills > 0) ? ((double)involvement / teamKills * 100.0) : 0.0;
 
-                stats.valid = true;
-                // SAFE ACCESS: Use .value() defaults to prevent crashes
-                stats.champion_name = userP.value("championName", "Unknown");
-                stats.kills = userP.value("kills", 0);
-                stats.deaths = userP.value("deaths", 0);
-                stats.assists = userP.value("assists", 0);
-                stats.win = userP.value("win", false);
-                stats.timestamp = info.value("gameCreation", 0LL);
-                stats.gameDuration = gameDuration;
-
-                int involvement = stats.kills + stats.assists;
-                stats.kp_percent = (teamKills > 0) ? ((double)involvement / teamKills * 100.0) : 0.0;
-
-                int totalMinions = userP.value("totalMinionsKilled", 0);
-                int neutralMinions = userP.value("neutralMinionsKilled", 0);
-                stats.cs = totalMinions + neutralMinions;
-                stats.cs_min = (gameDuration > 0) ? (stats.cs / (gameDuration / 60.0)) : 0.0;
-            }
-        }
-        catch (const std::exception &e)
-        {
-            std::cerr << "Error analyzing match JSON: " << e.what() << std::endl;
-            stats.valid = false;
-        }
+        stats.cs = userP->total_minions + userP->neutral_minions;
+        stats.cs_min = (gameDuration > 0) ? (stats.cs / (gameDuration / 60.0)) : 0.0;
 
         return stats;
     }
-} // namespace Server::Riot
\ No newline at end of file
+} // namespace Server::Riot
@@ -1,10 +1,20 @@
 #pragma once
+#include "server/riot/MatchCache.h"
 #include "server/riot/RateLimiter.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <dpp/dpp.h>
+#include <functional>
+#include <future>
 #include <map>
 #include <memory>
 #include <nlohmann/json.hpp>
+#include <optional>
+#include <shared_mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace Server::Riot
 {
@@ -23,26 +33,150 @@ namespace Server::Riot
         bool win;
     };
 
+    // Filters for the match-v5 by-puuid /ids endpoint (newest first)
+    struct MatchListQuery
+    {
+        int count = 5;
+        int start = 0;          // Offset into the list, for paging
+        int64_t start_time = 0; // Epoch seconds; only matches after this (0 = no lower bound)
+    };
+
+    struct RiotClientOptions
+    {
+        // Memory budget of the shared match summary cache (0 disables caching)
+        size_t match_cache_bytes = 16 * 1024 * 1024;
+
+        // App rate limits, all enforced at once. Defaults are Riot's development key limits.
+        std::vector<RateLimit> rate_limits = {{20, std::chrono::seconds(1)}, {100, std::chrono::minutes(2)}};
+    };
+
     class RiotClient
     {
     public:
-        RiotClient(std::shared_ptr<dpp::cluster> bot, const std::string &apiKey);
+        template <typename T> using Callback = std::function<void(T)>;
+
+        RiotClient(std::shared_ptr<dpp::cluster> bot, const std::string &apiKey, const RiotClientOptions &options = {});
+        ~RiotClient();
+
+        // --- Asynchronous API ---
+        // These return immediately. Rate-limit waits happen on the client's dispatcher thread and HTTP I/O on
+        // D++'s, so any number of calls can be in flight without tying up TaskManager workers.
+        // Callbacks run on one of those threads: keep them short (submit a Task for heavy work) and never
+        // call a blocking RiotClient method from inside one.
+
+        void GetAccountAsync(const std::string &name, const std::string &tag, const std::string &region,
+                             Callback<std::tuple<std::string, std::string, std::string>> done);
+
+        // nullopt if the request failed (timeout, error status, 429 after retries), as opposed to an empty list
+        void GetLastMatchesAsync(const std::string &puuid, const std::string &region, const MatchListQuery &query,
+                                 Callback<std::optional<std::vector<std::string>>> done);
+
+        void AnalyzeMatchAsync(const std::string &match_id, const std::string &puuid, const std::string &region,
+                               Callback<MatchStats> done);
+
+        void GetMatchSummaryAsync(const std::string &match_id, const std::string &region,
+                                  Callback<std::shared_ptr<const MatchSummary>> done);
+
+        // --- Blocking API ---
+        // Wrappers over the async calls that park the calling thread until the result arrives.
 
         std::tuple<std::string, std::string, std::string> GetAccount(const std::string &name, const std::string &tag,
                                                                      const std::string &region);
 
-        // Count defaults to 5 now to catch missed games
-        std::vector<std::string> GetLastMatches(const std::string &puuid, const std::string &region, int count = 5);
+        // Count defaults to 5 now to catch missed games. nullopt if the request failed.
+        std::optional<std::vector<std::string>> GetLastMatches(const std::string &puuid, const std::string &region, int count = 5);
+        std::optional<std::vector<std::string>> GetLastMatches(const std::string &puuid, const std::string &region,
+                                                               const MatchListQuery &query);
 
         MatchStats AnalyzeMatch(const std::string &match_id, const std::string &puuid, const std::string &region);
 
+        // Every participant's stats for a match; served from the shared cache when possible.
+        // Returns nullptr if the match could not be downloaded or parsed.
+        std::shared_ptr<const MatchSummary> GetMatchSummary(const std::string &match_id, const std::string &region);
+
+        // One player's MatchStats from an already fetched summary (what AnalyzeMatch returns). Pure CPU work.
+        // Returns stats with valid = false if the player is not in the match.
+        static MatchStats StatsFor(const MatchSummary &summary, const std::string &puuid);
+
+        const MatchCache &GetMatchCache() const { return m_matchCache; }
+
     private:
+        // A request waiting for rate-limit slots, or being retried after a 429
+        struct PendingRequest
+        {
+            std::string route;
+            std::string method;
+            std::string url;
+            int attempt = 0;
+            Callback<std::optional<std::string>> done;
+        };
+
+        // A request handed to D++. Whichever of the response or the timeout comes first completes it.
+        struct InFlightRequest
+        {
+            PendingRequest request;
+            std::chrono::steady_clock::time_point deadline;
+            std::atomic<bool> finished{false};
+        };
+
         std::shared_ptr<dpp::cluster> m_bot;
         std::string m_apiKey;
-        std::unique_ptr<RateLimiter> m_limiter; // Added RateLimiter
         std::map<std::string, std::string> m_routing;
 
+        // Riot scopes rate limits per routing value (app limits) and per routing value + endpoint
+        // (method limits). Both are learned from response headers; app limits start from the config.
+        std::vector<RateLimit> m_defaultAppLimits;
+        std::mutex m_limiterMutex;
+        std::map<std::string, std::unique_ptr<RateLimiter>> m_appLimiters;    // by route
+        std::map<std::string, std::unique_ptr<RateLimiter>> m_methodLimiters; // by "route method"
+
+        // Shared match summaries, plus single-flight bookkeeping so concurrent misses
+        // for the same match (a five-stack checked on five workers) share one download.
+        MatchCache m_matchCache;
+        std::mutex m_loadingMutex;
+        std::map<std::string, std::vector<Callback<std::shared_ptr<const MatchSummary>>>> m_loading;
+
+        // Dispatcher: releases queued requests as their limiters allow and times out lost responses
+        std::mutex m_dispatchMutex;
+        std::condition_variable m_dispatchCv;
+        std::deque<PendingRequest> m_pending;
+        std::vector<std::shared_ptr<InFlightRequest>> m_inFlight;
+        bool m_stopping = false;
+        std::thread m_dispatcher;
+
+        // D++ response callbacks can outlive the client (the cluster is shared), so they reach it through
+        // this instead of `this`. The destructor clears it, waiting for callbacks already running.
+        struct Lifeline
+        {
+            std::shared_mutex mutex;
+            RiotClient *client = nullptr;
+        };
+        std::shared_ptr<Lifeline> m_lifeline;
+
         std::string GetRoute(const std::string &region);
-        nlohmann::json Request(const std::string &url);
+        RateLimiter &AppLimiter(const std::string &route);
+        RateLimiter &MethodLimiter(const std::string &route, const std::string &method);
+        void ApplyRateLimitHeaders(RateLimiter &app, RateLimiter &method, const dpp::http_request_completion_t &response);
+
+        // Raw 200 body, rate limited and retried. `method` names the endpoint for Riot's per-method limits.
+        void RequestBodyAsync(const std::string &route, const std::string &method, const std::string &url,
+                              Callback<std::optional<std::string>> done);
+        void RequestJsonAsync(const std::string &route, const std::string &method, const std::string &url,
+                              Callback<nlohmann::json> done);
+
+        void DispatchLoop();
+        void Send(PendingRequest request);
+        void OnResponse(const std::shared_ptr<InFlightRequest> &flight, const dpp::http_request_completion_t &response);
+        static void Complete(PendingRequest &request, std::optional<std::string> body);
+
+
+        // Runs an async call and blocks until its callback fires
+        template <typename T, typename Start> static T Await(Start &&start)
+        {
+            auto promise = std::make_shared<std::promise<T>>();
+            auto future = promise->get_future();
+            start([promise](T value) { promise->set_value(std::move(value)); });
+            return future.get();
+        }
     };
-} // namespace Server::Riot
\ No newline at end of file
+} // namespace Server::Riot
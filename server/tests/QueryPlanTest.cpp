@@ -0,0 +1,86 @@
+// Every hot query must be answered from an index. Opens a fresh database through Database (so all
+// schema migrations run), asks SQLite for the plan of each hot query and fails if any step of it is
+// a full table scan ("SCAN <table>"). Searches, covering indexes and temp B-trees for ORDER BY are fine.
+//
+// The statements are the ones Database runs, from server/database/HotQueries.h.
+#include "server/database/Database.h"
+#include "server/database/HotQueries.h"
+#include <filesystem>
+#include <iostream>
+#include <sqlite3.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Plan steps that read a whole table, e.g. "SCAN games" or "SCAN g USING COVERING INDEX ..."
+    std::vector<std::string> TableScans(sqlite3 *db, const std::string &sql, bool &ok)
+    {
+        std::vector<std::string> scans;
+        sqlite3_stmt *stmt = nullptr;
+        if (sqlite3_prepare_v2(db, ("EXPLAIN QUERY PLAN " + sql).c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+        {
+            std::cerr << "  cannot prepare: " << sqlite3_errmsg(db) << std::endl;
+            ok = false;
+            return scans;
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            std::string detail = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 3));
+            if (detail.rfind("SCAN ", 0) == 0 && detail != "SCAN CONSTANT ROW")
+                scans.push_back(detail);
+        }
+        sqlite3_finalize(stmt);
+        return scans;
+    }
+} // namespace
+
+int main()
+{
+    auto path = (std::filesystem::temp_directory_path() / "log_query_plan_test.db").string();
+    auto removeFiles = [&]
+    {
+        for (const char *suffix : {"", "-wal", "-shm"})
+            std::filesystem::remove(path + suffix);
+    };
+    removeFiles();
+
+    // Creates the version-0 tables and applies every migration
+    {
+        Server::DB::Database schema(path, 0);
+    }
+
+    sqlite3 *db = nullptr;
+    if (sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK)
+    {
+        std::cerr << "Cannot open " << path << ": " << sqlite3_errmsg(db) << std::endl;
+        return 1;
+    }
+
+    std::vector<std::pair<std::string, std::string>> queries;
+    for (const auto &query : Server::DB::HotSql::ALL)
+        queries.emplace_back(query.caller, query.sql);
+    for (const char *column : {"wimp_mult_upper", "wimp_mult_lower", "wimp_mult_core"})
+        queries.emplace_back(std::string("GetUserMultiplier (") + column + ")", Server::DB::HotSql::UserMultiplier(column));
+
+    int failures = 0;
+    for (const auto &[caller, sql] : queries)
+    {
+        bool ok = true;
+        auto scans = TableScans(db, sql, ok);
+        if (ok && scans.empty())
+        {
+            std::cout << "ok    " << caller << std::endl;
+            continue;
+        }
+        ++failures;
+        std::cout << "FAIL  " << caller << std::endl;
+        for (const auto &scan : scans)
+            std::cout << "      " << scan << std::endl;
+    }
+
+    sqlite3_close(db);
+    removeFiles();
+    std::cout << failures << " of " << queries.size() << " hot queries scan a table" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
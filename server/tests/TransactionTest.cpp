@@ -0,0 +1,186 @@
+// A write that fails inside a unit of work must never be committed as if it had succeeded. Failures are
+// forced with triggers that RAISE for one user, on a fresh database built through Database.
+//
+// Covers the two ways a failure reaches the caller: a statement failing in the outer transaction makes
+// Commit() return false, and one failing inside LogGame/AddToQueue (which are savepoints, so the outer
+// transaction doesn't see it) makes them and RecordMatch return false, so the tracker rolls back instead
+// of advancing the cursor past a game that was never stored.
+#include "server/database/Database.h"
+#include "server/tracker/MatchRecorder.h"
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <sqlite3.h>
+#include <string>
+#include <vector>
+
+using Server::DB::Database;
+
+namespace
+{
+    const int64_t GOOD_USER = 1;
+    const int64_t FAILING_USER = 666; // The triggers below raise for this user (and one match ID)
+
+    const char *FAILURE_TRIGGERS = R"(
+        CREATE TRIGGER fail_user_stats BEFORE INSERT ON user_stats WHEN NEW.user_id = 666
+            BEGIN SELECT RAISE(ABORT, 'forced failure'); END;
+        CREATE TRIGGER fail_queue BEFORE INSERT ON exercise_queue WHEN NEW.user_id = 666
+            BEGIN SELECT RAISE(ABORT, 'forced failure'); END;
+        CREATE TRIGGER fail_game BEFORE INSERT ON games WHEN NEW.match_id = 'NA1_broken'
+            BEGIN SELECT RAISE(ABORT, 'forced failure'); END;
+        CREATE TRIGGER fail_cursor BEFORE UPDATE ON users WHEN OLD.discord_id = 666
+            BEGIN SELECT RAISE(ABORT, 'forced failure'); END;
+    )";
+
+    Server::DB::User Link(int64_t discord_id)
+    {
+        Server::DB::User user;
+        user.discord_id = discord_id;
+        user.riot_puuid = "puuid-" + std::to_string(discord_id);
+        user.riot_name = "Player" + std::to_string(discord_id);
+        user.riot_tag = "NA1";
+        user.region = "na1";
+        return user;
+    }
+
+    Server::Riot::MatchStats Stats(int deaths)
+    {
+        Server::Riot::MatchStats stats;
+        stats.valid = true;
+        stats.champion_name = "Ahri";
+        stats.kills = 5;
+        stats.deaths = deaths;
+        stats.assists = 7;
+        stats.timestamp = 1700000000000LL;
+        stats.gameDuration = 1800;
+        return stats;
+    }
+
+    bool LogGame(Database &db, int64_t user, const std::string &match_id)
+    {
+        return db.LogGame(user, match_id, 1700000000000LL, 1800, "Ahri", 5, 3, 7, 50.0, 180, 6.0);
+    }
+
+    int64_t Cursor(Database &db, int64_t discord_id)
+    {
+        auto links = db.GetDiscordUsers(discord_id);
+        return links.empty() ? -1 : links.front().last_match_time;
+    }
+
+    // -------------------------------------------------------------------------
+    // CASES
+    // -------------------------------------------------------------------------
+    bool FailedStatementFailsCommit(Database &db)
+    {
+        // The tracker's cursor advance: a failed UPDATE takes the game logged with it down too
+        Database::Transaction tx(db);
+        LogGame(db, GOOD_USER, "NA1_cursor");
+        db.UpdateLastMatch(FAILING_USER, "puuid-666", "NA1_cursor", 1700001800);
+        return !tx.Commit() && !db.IsMatchProcessed(GOOD_USER, "NA1_cursor");
+    }
+
+    bool FailedLogGameIsReported(Database &db)
+    {
+        Database::Transaction tx(db);
+        bool logged = LogGame(db, FAILING_USER, "NA1_log");
+        tx.Commit();
+        return !logged && !db.IsMatchProcessed(FAILING_USER, "NA1_log");
+    }
+
+    bool FailedGameInsertIsNotADuplicate(Database &db)
+    {
+        // The game insert changing no rows is also how LogGame sees a duplicate; a failure must still count
+        Database::Transaction tx(db);
+        bool logged = LogGame(db, GOOD_USER, "NA1_broken");
+        tx.Commit();
+        return !logged && !db.IsMatchProcessed(GOOD_USER, "NA1_broken");
+    }
+
+    bool DuplicateLogGameSucceeds(Database &db)
+    {
+        Database::Transaction tx(db);
+        bool first = LogGame(db, GOOD_USER, "NA1_dup");
+        bool again = LogGame(db, GOOD_USER, "NA1_dup"); // Nothing inserted, but nothing failed either
+        return first && again && tx.Commit() && db.IsMatchProcessed(GOOD_USER, "NA1_dup");
+    }
+
+    bool FailedRecordMatchKeepsCursor(Database &db)
+    {
+        // As TaskCheckUserMatch::RecordPoll and TrackerPipeline::Persist use it: a false RecordMatch
+        // abandons the transaction, so neither the game nor the cursor advance is kept
+        auto good = db.GetDiscordUsers(GOOD_USER).front();
+        auto failing = db.GetDiscordUsers(FAILING_USER).front();
+        int64_t cursor = Cursor(db, GOOD_USER);
+        {
+            Database::Transaction tx(db);
+            std::optional<std::string> notification;
+            bool recorded = Core::Tracker::RecordMatch(db, good, "NA1_poll", Stats(4), notification) &&
+                            Core::Tracker::RecordMatch(db, failing, "NA1_poll", Stats(4), notification);
+            if (recorded)
+            {
+                db.UpdateLastMatch(GOOD_USER, good.riot_puuid, "NA1_poll", 1700001800);
+                tx.Commit();
+            }
+        }
+        return !db.IsMatchProcessed(GOOD_USER, "NA1_poll") && !db.IsMatchProcessed(FAILING_USER, "NA1_poll") &&
+               db.GetPendingPenance(GOOD_USER).empty() && Cursor(db, GOOD_USER) == cursor;
+    }
+
+    bool RecordMatchSucceeds(Database &db)
+    {
+        auto good = db.GetDiscordUsers(GOOD_USER).front();
+        Database::Transaction tx(db);
+        std::optional<std::string> notification;
+        bool recorded = Core::Tracker::RecordMatch(db, good, "NA1_ok", Stats(2), notification);
+        return recorded && notification && tx.Commit() && db.IsMatchProcessed(GOOD_USER, "NA1_ok") &&
+               db.GetPendingPenance(GOOD_USER).size() == 1;
+    }
+} // namespace
+
+int main()
+{
+    auto path = (std::filesystem::temp_directory_path() / "log_transaction_test.db").string();
+    auto removeFiles = [&]
+    {
+        for (const char *suffix : {"", "-wal", "-shm"})
+            std::filesystem::remove(path + suffix);
+    };
+    removeFiles();
+
+    int failures = 0;
+    size_t cases = 0;
+    {
+        Database db(path, 0);
+        db.AddUser(Link(GOOD_USER));
+        db.AddUser(Link(FAILING_USER));
+
+        sqlite3 *schema = nullptr;
+        sqlite3_open(path.c_str(), &schema);
+        if (sqlite3_exec(schema, FAILURE_TRIGGERS, nullptr, nullptr, nullptr) != SQLITE_OK)
+        {
+            std::cerr << "Cannot create the failure triggers: " << sqlite3_errmsg(schema) << std::endl;
+            return 1;
+        }
+        sqlite3_close(schema);
+
+        const std::pair<const char *, std::function<bool(Database &)>> CASES[] = {
+            {"failed statement fails Commit()", FailedStatementFailsCommit},
+            {"failed LogGame returns false", FailedLogGameIsReported},
+            {"failed game insert returns false", FailedGameInsertIsNotADuplicate},
+            {"duplicate LogGame returns true", DuplicateLogGameSucceeds},
+            {"failed RecordMatch keeps the cursor", FailedRecordMatchKeepsCursor},
+            {"RecordMatch stores game and penance", RecordMatchSucceeds},
+        };
+        cases = std::size(CASES);
+        for (const auto &[name, run] : CASES)
+        {
+            bool ok = run(db);
+            failures += ok ? 0 : 1;
+            std::cout << (ok ? "ok    " : "FAIL  ") << name << std::endl;
+        }
+    }
+
+    removeFiles();
+    std::cout << failures << " of " << cases << " cases failed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
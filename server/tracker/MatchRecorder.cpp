@@ -0,0 +1,120 @@
+#include "server/tracker/MatchRecorder.h"
+#include <algorithm>
+#include <iostream>
+
+namespace Core::Tracker
+{
+    bool RecordMatch(Server::DB::Database &db, const Server::DB::User &user, const std::string &match_id,
+                     const Server::Riot::MatchStats &stats, std::optional<std::string> &notification)
+    {
+        notification.reset();
+        if (!db.LogGame(user.discord_id, match_id, stats.timestamp, stats.gameDuration, stats.champion_name, stats.kills,
+                        stats.deaths, stats.assists, stats.kp_percent, stats.cs, stats.cs_min))
+            return false;
+
+        if (stats.deaths > 0)
+        {
+            auto exOpt = db.GetRandomExercise();
+            std::string exName = "Pushups";
+            int baseReps = 10;
+            std::string type = "upper";
+
+            if (exOpt)
+            {
+                exName = exOpt->name;
+                baseReps = exOpt->set_count;
+                type = exOpt->type;
+            }
+
+            // Each Discord user's own multipliers apply, even when several share the account
+            double multiplier = 1.0;
+            if (type == "lower")
+                multiplier = user.mult_lower;
+            else if (type == "core")
+                multiplier = user.mult_core;
+            else
+                multiplier = user.mult_upper;
+
+            int totalReps = static_cast<int>(stats.deaths * baseReps * multiplier);
+            if (totalReps < 1)
+                totalReps = 1;
+
+            if (!db.AddToQueue(user.discord_id, match_id, exName, totalReps, stats.deaths))
+                return false;
+
+            notification = "💀 **New Match Detected** (" + user.riot_name + ")\nDeaths: " + std::to_string(stats.deaths) +
+                           "\nPenance: " + std::to_string(totalReps) + " " + exName + " (" + type + ")";
+        }
+        return true;
+    }
+
+    int64_t AccountCursor(const std::vector<Server::DB::User> &links)
+    {
+        int64_t cursor = 0;
+        for (const auto &user : links)
+        {
+            if (user.last_match_time <= 0)
+                return 0;
+            if (cursor == 0 || user.last_match_time < cursor)
+                cursor = user.last_match_time;
+        }
+        return cursor;
+    }
+
+    Server::Riot::MatchListQuery FirstMatchListPage(int64_t cursor)
+    {
+        Server::Riot::MatchListQuery query;
+        if (cursor <= 0)
+        {
+            query.count = INITIAL_MATCH_COUNT;
+            return query;
+        }
+        query.count = INCREMENTAL_PAGE_SIZE;
+        query.start_time = cursor + 1;
+        return query;
+    }
+
+    std::optional<Server::Riot::MatchListQuery> NextMatchListPage(const Server::Riot::MatchListQuery &page, size_t returned,
+                                                                  PollProgress &progress)
+    {
+        // The fixed window is a single page; an incremental poll pages until a short page or the cap
+        if (page.start_time <= 0 || returned < static_cast<size_t>(page.count))
+            return std::nullopt;
+        Server::Riot::MatchListQuery next = page;
+        next.start = page.start + page.count;
+        next.count = std::min(MATCH_LIST_PAGE_SIZE, MAX_LISTED_MATCHES - next.start);
+        if (next.count <= 0)
+        {
+            progress.truncated = true;
+            return std::nullopt;
+        }
+        return next;
+    }
+
+    void PrepareMatchList(std::vector<std::string> &matches, PollProgress &progress, const std::string &account)
+    {
+        std::reverse(matches.begin(), matches.end());
+        if (matches.size() > MAX_MATCHES_PER_POLL)
+        {
+            progress.deferred = matches.size() - MAX_MATCHES_PER_POLL;
+            matches.resize(MAX_MATCHES_PER_POLL);
+            std::cout << "[Tracker] " << account << ": processing the oldest " << MAX_MATCHES_PER_POLL << " new games, "
+                      << progress.deferred << " left for the next poll" << std::endl;
+        }
+        if (progress.truncated)
+        {
+            std::cerr << "[Tracker] " << account << ": more than " << MAX_LISTED_MATCHES
+                      << " games since the cursor; holding it so the unlisted ones aren't skipped" << std::endl;
+        }
+    }
+
+    void AdvanceCursors(Server::DB::Database &db, const std::vector<Server::DB::User> &links, const PollProgress &progress)
+    {
+        // A truncated list may have skipped games older than every listed one; moving past the listed
+        // ones would lose those for good
+        if (progress.failed || progress.truncated || progress.newest_end <= 0)
+            return;
+        for (const auto &user : links)
+            db.UpdateLastMatch(user.discord_id, user.riot_puuid, progress.newest_match, progress.newest_end);
+    }
+} // namespace Core::Tracker
@@ -0,0 +1,77 @@
+#pragma once
+#include "server/database/Database.h"
+#include "server/riot/RiotClient.h"
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Core::Tracker
+{
+    /**
+     * @brief Records one analysed match for one Discord link.
+     * Logs the game and queues a penance scaled by the user's own multipliers if they died. The link's
+     * poll cursor is advanced separately, once the whole poll succeeded (see AdvanceCursors).
+     * Shared by the task-based and pipelined tracker engines.
+     * @param notification Set to the "New Match Detected" DM to send the user, if there is something to report.
+     * @return false if a write failed. The writes are savepoints, so the caller's Transaction would still
+     *         commit: it must roll back instead, or the cursor moves past a game that was never stored.
+     */
+    bool RecordMatch(Server::DB::Database &db, const Server::DB::User &user, const std::string &match_id,
+                     const Server::Riot::MatchStats &stats, std::optional<std::string> &notification);
+
+    // Match lists are polled incrementally from a per-link cursor: the end time (epoch seconds) of the
+    // newest game processed for the link. Links without one fall back to the fixed recent window.
+    constexpr int INITIAL_MATCH_COUNT = 15;
+    constexpr int INCREMENTAL_PAGE_SIZE = 20;  // First page; covers a normal gap between polls in one request
+    constexpr int MATCH_LIST_PAGE_SIZE = 100;  // Later pages, at Riot's maximum count
+    constexpr int MAX_LISTED_MATCHES = 1000;   // Paging stops here even if Riot has more
+    constexpr size_t MAX_MATCHES_PER_POLL = 100; // Oldest games processed per poll; the rest wait for the next one
+
+    /// @brief End time of a match in epoch seconds, the unit of the poll cursor.
+    inline int64_t MatchEndTime(const Server::Riot::MatchStats &stats) { return stats.timestamp / 1000 + stats.gameDuration; }
+
+    /// @brief Cursor of an account: the oldest cursor among its links, or 0 if any link has none yet.
+    int64_t AccountCursor(const std::vector<Server::DB::User> &links);
+
+    /**
+     * @brief What one poll of an account saw, to advance its links' cursors afterwards.
+     * A single failed request (match list page or match) holds every cursor back so the next poll
+     * fetches it again; the matches that did succeed are skipped then by the usual processed check.
+     */
+    struct PollProgress
+    {
+        std::string newest_match;
+        int64_t newest_end = 0;
+        size_t new_matches = 0; // Matches that were new for at least one link (account activity)
+        bool failed = false;
+        bool truncated = false; // Paging hit MAX_LISTED_MATCHES, so older games after the cursor went unlisted
+        size_t deferred = 0;    // Listed games left for the next poll by MAX_MATCHES_PER_POLL
+
+        void Saw(const std::string &match_id, int64_t end_time)
+        {
+            if (end_time > newest_end)
+            {
+                newest_end = end_time;
+                newest_match = match_id;
+            }
+        }
+    };
+
+    /// @brief First /ids query of a poll: games that ended after the cursor, or the recent window without one.
+    Server::Riot::MatchListQuery FirstMatchListPage(int64_t cursor);
+
+    /// @brief The query for the next page if `page` came back full and may have more behind it.
+    /// Sets `progress.truncated` when the MAX_LISTED_MATCHES cap is what stops the paging.
+    std::optional<Server::Riot::MatchListQuery> NextMatchListPage(const Server::Riot::MatchListQuery &page, size_t returned,
+                                                                  PollProgress &progress);
+
+    /**
+     * @brief Turns a poll's listed ids (Newest -> Oldest, as Riot returns them) into the matches to process,
+     * Oldest -> Newest. Only the oldest MAX_MATCHES_PER_POLL are kept: the cursor then stops at the newest
+     * of those, so the games left over are listed again by the next poll. Logs when a poll is cut short.
+     */
+    void PrepareMatchList(std::vector<std::string> &matches, PollProgress &progress, const std::string &account);
+
+    /// @brief Moves every link's cursor up to the newest match of a fully successful poll.
+    void AdvanceCursors(Server::DB::Database &db, const std::vector<Server::DB::User> &links, const PollProgress &progress);
+} // namespace Core::Tracker
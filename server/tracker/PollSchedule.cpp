@@ -0,0 +1,108 @@
+#include "server/tracker/PollSchedule.h"
+#include <algorithm>
+#include <iostream>
+
+namespace Core::Tracker
+{
+    PollSchedule::PollSchedule(const PollScheduleOptions &options) : m_options(options)
+    {
+        m_options.min_interval = std::max(m_options.min_interval, std::chrono::seconds(1));
+        m_options.max_interval = std::max(m_options.max_interval, m_options.min_interval);
+        m_options.backoff = std::max(m_options.backoff, 1.0);
+        m_options.jitter = std::clamp(m_options.jitter, 0.0, 0.5);
+    }
+
+    std::vector<std::vector<Server::DB::User>> PollSchedule::Due(std::vector<std::vector<Server::DB::User>> accounts)
+    {
+        auto now = std::chrono::steady_clock::now();
+        std::vector<std::vector<Server::DB::User>> due;
+        size_t dormant = 0;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        uint64_t generation = ++m_generation;
+        for (auto &links : accounts)
+        {
+            if (links.empty())
+                continue;
+
+            auto [it, inserted] = m_entries.try_emplace(Key(links.front()));
+            Entry &entry = it->second;
+            entry.generation = generation;
+            if (inserted)
+            {
+                // Random phase within the first interval spreads a fresh schedule (e.g. at startup) evenly
+                entry.interval = InitialInterval(links);
+                std::uniform_int_distribution<int64_t> phase(0, std::chrono::duration_cast<std::chrono::steady_clock::duration>(entry.interval).count());
+                entry.next_due = now + std::chrono::steady_clock::duration(phase(m_rng));
+            }
+
+            if (entry.interval >= m_options.max_interval)
+                dormant++;
+            if (entry.next_due > now)
+                continue;
+
+            entry.next_due = now + Jittered(entry.interval);
+            due.push_back(std::move(links));
+        }
+
+        // Forget accounts that were unlinked
+        std::erase_if(m_entries, [generation](const auto &item) { return item.second.generation != generation; });
+
+        if (!due.empty())
+        {
+            std::cout << "[Tracker] Polling " << due.size() << " of " << m_entries.size() << " accounts (" << dormant
+                      << " dormant)" << std::endl;
+        }
+        return due;
+    }
+
+    void PollSchedule::Report(const std::string &key, bool active)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(key);
+        if (it == m_entries.end())
+            return;
+
+        Entry &entry = it->second;
+        if (active)
+        {
+            entry.interval = m_options.min_interval;
+        }
+        else
+        {
+            auto grown = std::chrono::seconds(static_cast<int64_t>(entry.interval.count() * m_options.backoff));
+            entry.interval = std::min(grown, m_options.max_interval);
+        }
+        entry.next_due = std::chrono::steady_clock::now() + Jittered(entry.interval);
+    }
+
+    void PollSchedule::Retry(const std::string &key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(key);
+        if (it != m_entries.end())
+            it->second.next_due = std::chrono::steady_clock::now();
+    }
+
+    std::chrono::seconds PollSchedule::InitialInterval(const std::vector<Server::DB::User> &links) const
+    {
+        // Until the first poll reports back, guess from how long ago the account's last game ended:
+        // about an eighth of that idle time, so a week-old account starts near the ceiling
+        int64_t lastGame = 0;
+        for (const auto &user : links)
+            lastGame = std::max(lastGame, user.last_match_time);
+        if (lastGame <= 0)
+            return m_options.min_interval;
+
+        int64_t now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        auto guess = std::chrono::seconds(std::max<int64_t>(0, now - lastGame) / 8);
+        return std::clamp(guess, m_options.min_interval, m_options.max_interval);
+    }
+
+    std::chrono::steady_clock::duration PollSchedule::Jittered(std::chrono::seconds interval)
+    {
+        std::uniform_real_distribution<double> factor(1.0 - m_options.jitter, 1.0 + m_options.jitter);
+        return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(interval.count() * factor(m_rng)));
+    }
+} // namespace Core::Tracker
@@ -0,0 +1,74 @@
+#pragma once
+#include "server/database/Database.h"
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Core::Tracker
+{
+    struct PollScheduleOptions
+    {
+        // Poll interval right after an account produced a game, and the ceiling it backs off to
+        std::chrono::seconds min_interval{120};
+        std::chrono::seconds max_interval{1800};
+
+        // Interval growth per poll that found nothing new
+        double backoff = 2.0;
+
+        // Each interval is randomised by +/- this fraction so accounts stay spread over the window
+        double jitter = 0.1;
+
+        // How often the sweep timer looks for due accounts
+        std::chrono::seconds tick{30};
+    };
+
+    /**
+     * @brief Per-account poll cadence for the tracker.
+     * An account that just produced a game is polled every `min_interval`; each empty poll multiplies
+     * its interval by `backoff` up to `max_interval`. New accounts start at a random phase within their
+     * first interval and every interval is jittered, so polls trickle out over each tick instead of
+     * firing as one burst.
+     */
+    class PollSchedule
+    {
+    public:
+        explicit PollSchedule(const PollScheduleOptions &options);
+
+        // "puuid|region" of the account a link belongs to
+        static std::string Key(const Server::DB::User &user) { return user.riot_puuid + "|" + user.region; }
+
+        const PollScheduleOptions &Options() const { return m_options; }
+
+        // Picks the accounts due for a poll out of `accounts` (the Discord links of each Riot account)
+        // and books their next poll one interval out, in case no Report arrives. Accounts no longer
+        // linked are forgotten.
+        std::vector<std::vector<Server::DB::User>> Due(std::vector<std::vector<Server::DB::User>> accounts);
+
+        // Outcome of a poll: `active` if it found new games. Schedules the account's next poll.
+        void Report(const std::string &key, bool active);
+
+        // Makes an account due again right away, keeping its interval (e.g. its poll was deferred by a full
+        // queue, or its match list request failed).
+        void Retry(const std::string &key);
+
+    private:
+        struct Entry
+        {
+            std::chrono::seconds interval;
+            std::chrono::steady_clock::time_point next_due;
+            uint64_t generation = 0; // Last Due() call that saw the account
+        };
+
+        std::chrono::seconds InitialInterval(const std::vector<Server::DB::User> &links) const;
+        std::chrono::steady_clock::duration Jittered(std::chrono::seconds interval);
+
+        PollScheduleOptions m_options;
+        std::mutex m_mutex;
+        std::unordered_map<std::string, Entry> m_entries;
+        uint64_t m_generation = 0;
+        std::mt19937 m_rng{std::random_device{}()};
+    };
+} // namespace Core::Tracker
@@ -0,0 +1,272 @@
+#include "server/tracker/TrackerPipeline.h"
+#include "server/tracker/MatchRecorder.h"
+#include <iomanip>
+#include <sstream>
+
+namespace Core::Tracker
+{
+    TrackerPipeline::TrackerPipeline(const TrackerPipelineOptions &options, std::shared_ptr<dpp::cluster> bot,
+                                     std::shared_ptr<Server::DB::Database> db, std::shared_ptr<Server::Riot::RiotClient> riot,
+                                     std::shared_ptr<PollSchedule> schedule)
+        : m_options(options), m_bot(bot), m_db(db), m_riot(riot), m_schedule(schedule), m_list("match-list", options.queue_capacity),
+          m_filter("filter", options.queue_capacity), m_detail("match-detail", options.queue_capacity),
+          m_stats("stats", options.queue_capacity), m_persist("persist", options.queue_capacity),
+          m_notify("notify", options.queue_capacity)
+    {
+        m_nextStatsLog = (std::chrono::steady_clock::now() + m_options.stats_interval).time_since_epoch().count();
+
+        auto afterEach = [this] { MaybeLogStats(); };
+        m_list.Start(m_options.list_threads, [this](AccountJob &job) { FetchMatchList(job); }, afterEach);
+        m_filter.Start(m_options.filter_threads, [this](MatchListJob &job) { FilterNewMatches(job); }, afterEach);
+        m_detail.Start(m_options.detail_threads, [this](MatchJob &job) { FetchMatchDetail(job); }, afterEach);
+        m_stats.Start(m_options.stats_threads, [this](SummaryJob &job) { ExtractStats(job); }, afterEach);
+        m_persist.Start(m_options.persist_threads, [this](StatsJob &job) { Persist(job); }, afterEach);
+        m_notify.Start(m_options.notify_threads, [this](NotifyJob &job) { Notify(job); }, afterEach);
+    }
+
+    TrackerPipeline::~TrackerPipeline()
+    {
+        // Upstream first, so no stage is left blocked pushing into one that already stopped
+        m_list.Stop();
+        m_filter.Stop();
+        m_detail.Stop();
+        m_stats.Stop();
+        m_persist.Stop();
+        m_notify.Stop();
+    }
+
+    void TrackerPipeline::Sweep(const std::vector<std::vector<Server::DB::User>> &accounts)
+    {
+        size_t queued = 0;
+        size_t inFlight = 0;
+        size_t deferred = 0;
+
+        for (const auto &links : accounts)
+        {
+            if (links.empty())
+                continue;
+
+            std::string key = links.front().riot_puuid + "|" + links.front().region;
+            {
+                std::lock_guard<std::mutex> lock(m_inFlightMutex);
+                if (!m_inFlight.insert(key).second)
+                {
+                    // Still being processed from an earlier sweep; it will see any new matches itself
+                    inFlight++;
+                    continue;
+                }
+            }
+
+            AccountJob job{std::shared_ptr<AccountRun>(new AccountRun{this, key, links}), links};
+            if (!m_list.TryPush(job))
+            {
+                // Pipeline is saturated: job (and its run marker) is dropped, leaving the rest for the next sweep
+                deferred++;
+                if (m_schedule)
+                    m_schedule->Retry(key);
+                continue;
+            }
+            queued++;
+        }
+
+        std::cout << "[Tracker] Pipeline sweep: " << queued << " accounts queued, " << inFlight << " still in flight";
+        if (deferred > 0)
+            std::cout << ", " << deferred << " deferred (match-list queue full)";
+        std::cout << std::endl;
+    }
+
+    // -------------------------------------------------------------------------
+    // STAGES
+    // -------------------------------------------------------------------------
+    void TrackerPipeline::FetchMatchList(AccountJob &job)
+    {
+        const auto &account = job.links.front();
+
+        // Only matches since the account's cursor, a page at a time (Riot returns Newest -> Oldest).
+        // Nothing else touches the run's progress until this stage hands the list on.
+        PollProgress &progress = job.run->progress;
+        std::vector<std::string> matches;
+        std::optional<Server::Riot::MatchListQuery> page = FirstMatchListPage(AccountCursor(job.links));
+        while (page)
+        {
+            auto ids = m_riot->GetLastMatches(account.riot_puuid, account.region, *page);
+            if (!ids)
+            {
+                // The cursors stay (the run is never listed) and the next poll lists it all again
+                std::cerr << "[Tracker] Failed to list matches for " << account.riot_name << ", will retry" << std::endl;
+                std::lock_guard<std::mutex> lock(job.run->mutex);
+                progress.failed = true;
+                return;
+            }
+            matches.insert(matches.end(), ids->begin(), ids->end());
+            page = NextMatchListPage(*page, ids->size(), progress);
+        }
+        {
+            std::lock_guard<std::mutex> lock(job.run->mutex);
+            job.run->polled = true;
+        }
+        if (matches.empty())
+            return;
+
+        // Oldest -> Newest, at most one poll's worth
+        PrepareMatchList(matches, progress, account.riot_name);
+
+        m_filter.Push(MatchListJob{std::move(job.run), std::move(job.links), std::move(matches)});
+    }
+
+    void TrackerPipeline::FilterNewMatches(MatchListJob &job)
+    {
+        for (const auto &match_id : job.matches)
+        {
+            std::vector<Server::DB::User> pending;
+            for (const auto &user : job.links)
+            {
+                if (auto end = m_db->GetProcessedMatchEnd(user.discord_id, match_id))
+                {
+                    std::lock_guard<std::mutex> lock(job.run->mutex);
+                    job.run->progress.Saw(match_id, *end);
+                }
+                else
+                {
+                    pending.push_back(user);
+                }
+            }
+            if (pending.empty())
+                continue; // Already processed for everyone, skip it.
+
+            {
+                std::lock_guard<std::mutex> lock(job.run->mutex);
+                job.run->progress.new_matches++;
+                job.run->outstanding++;
+            }
+            if (!m_detail.Push(MatchJob{job.run, job.links.front(), std::move(pending), match_id}))
+                return; // Shutting down
+        }
+
+        std::lock_guard<std::mutex> lock(job.run->mutex);
+        job.run->listed = true;
+    }
+
+    void TrackerPipeline::FetchMatchDetail(MatchJob &job)
+    {
+        auto summary = m_riot->GetMatchSummary(job.match_id, job.account.region);
+        if (!summary)
+        {
+            std::cerr << "Failed to analyze match " << job.match_id << " for user " << job.account.riot_name << std::endl;
+            std::lock_guard<std::mutex> lock(job.run->mutex);
+            job.run->progress.failed = true;
+            return;
+        }
+        m_stats.Push(SummaryJob{std::move(job), std::move(summary)});
+    }
+
+    void TrackerPipeline::ExtractStats(SummaryJob &job)
+    {
+        auto stats = Server::Riot::RiotClient::StatsFor(*job.summary, job.match.account.riot_puuid);
+        if (!stats.valid)
+        {
+            std::cerr << "Failed to analyze match " << job.match.match_id << " for user " << job.match.account.riot_name
+                      << std::endl;
+            std::lock_guard<std::mutex> lock(job.match.run->mutex);
+            job.match.run->progress.failed = true;
+            return;
+        }
+        m_persist.Push(StatsJob{std::move(job.match), std::move(stats)});
+    }
+
+    void TrackerPipeline::Persist(StatsJob &job)
+    {
+        // Every link's game row and penance in one commit
+        std::vector<NotifyJob> notifications;
+        Server::DB::Database::Transaction tx(*m_db);
+        bool recorded = true;
+        for (const auto &user : job.match.pending)
+        {
+            std::optional<std::string> notification;
+            recorded = RecordMatch(*m_db, user, job.match.match_id, job.stats, notification);
+            if (!recorded)
+                break;
+            if (notification)
+                notifications.push_back(NotifyJob{user.discord_id, std::move(*notification)});
+        }
+
+        std::lock_guard<std::mutex> lock(job.match.run->mutex);
+        if (!recorded || !tx.Commit()) // A failed link rolls back the others too
+        {
+            std::cerr << "[Tracker] Failed to record match " << job.match.match_id << std::endl;
+            job.match.run->progress.failed = true; // Leave the cursors so the next poll retries it
+            job.match.run->outstanding--;
+            return;
+        }
+        for (auto &notification : notifications)
+            m_notify.Push(std::move(notification));
+        job.match.run->progress.Saw(job.match.match_id, MatchEndTime(job.stats));
+        job.match.run->outstanding--;
+    }
+
+    void TrackerPipeline::Notify(NotifyJob &job) { m_bot->direct_message_create(job.discord_id, dpp::message(job.message)); }
+
+    void TrackerPipeline::FinishAccount(AccountRun &run)
+    {
+        // Runs once the last job referencing the account is gone, so no other thread touches `run`.
+        // A match dropped on the way (shutdown, stage error) leaves the cursors for the next sweep.
+        if (run.listed && run.outstanding == 0)
+        {
+            try
+            {
+                Server::DB::Database::Transaction tx(*m_db);
+                AdvanceCursors(*m_db, run.links, run.progress);
+                tx.Commit();
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "[Tracker] Failed to advance cursors for " << run.key << ": " << e.what() << std::endl;
+            }
+        }
+
+        // Only a listed match list says anything about the account's activity; a failed one is retried
+        // on the next tick instead of counting as a quiet poll
+        if (m_schedule && run.polled)
+            m_schedule->Report(run.key, run.progress.new_matches > 0);
+        else if (m_schedule && run.progress.failed)
+            m_schedule->Retry(run.key);
+
+        std::lock_guard<std::mutex> lock(m_inFlightMutex);
+        m_inFlight.erase(run.key);
+    }
+
+    // -------------------------------------------------------------------------
+    // STATISTICS
+    // -------------------------------------------------------------------------
+    std::vector<StageStats> TrackerPipeline::GetStats()
+    {
+        return {m_list.Stats(false),  m_filter.Stats(false),  m_detail.Stats(false),
+                m_stats.Stats(false), m_persist.Stats(false), m_notify.Stats(false)};
+    }
+
+    void TrackerPipeline::MaybeLogStats()
+    {
+        if (m_options.stats_interval.count() <= 0)
+            return;
+
+        int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+        int64_t due = m_nextStatsLog.load();
+        int64_t next = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(m_options.stats_interval).count();
+        if (now < due || !m_nextStatsLog.compare_exchange_strong(due, next))
+            return;
+
+        std::vector<StageStats> stats = {m_list.Stats(true),  m_filter.Stats(true),  m_detail.Stats(true),
+                                         m_stats.Stats(true), m_persist.Stats(true), m_notify.Stats(true)};
+
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(1) << "[Tracker] Pipeline stats (last " << m_options.stats_interval.count() << "s):";
+        for (const auto &s : stats)
+        {
+            out << "\n  " << std::left << std::setw(13) << s.name << std::right << " processed=" << s.processed
+                << " rate=" << (double)s.processed / m_options.stats_interval.count() << "/s queued=" << s.queued
+                << " hwm=" << s.high_water << " wait avg=" << s.avg_wait_ms << "ms service avg=" << s.avg_service_ms
+                << "ms max=" << s.max_service_ms << "ms";
+        }
+        std::cout << out.str() << std::endl;
+    }
+} // namespace Core::Tracker
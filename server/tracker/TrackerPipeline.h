@@ -0,0 +1,305 @@
+#pragma once
+#include "server/core/ThreadsafeQueue.h"
+#include "server/database/Database.h"
+#include "server/riot/RiotClient.h"
+#include "server/tracker/MatchRecorder.h"
+#include "server/tracker/PollSchedule.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <dpp/dpp.h>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace Core::Tracker
+{
+    struct TrackerPipelineOptions
+    {
+        // Threads per stage. Riot-bound stages spend their time waiting on HTTP, so they get more.
+        size_t list_threads = 2;
+        size_t filter_threads = 1;
+        size_t detail_threads = 4;
+        size_t stats_threads = 1;
+        size_t persist_threads = 1;
+        size_t notify_threads = 1;
+
+        // Capacity of each stage's input queue. A full queue blocks the stage feeding it (backpressure);
+        // a full first queue makes the sweep defer the remaining accounts to the next sweep.
+        size_t queue_capacity = 1000;
+
+        // How often per-stage statistics are logged (0 disables).
+        std::chrono::seconds stats_interval{300};
+    };
+
+    // Throughput/latency counters for one stage over the current reporting window.
+    struct StageStats
+    {
+        std::string name;
+        uint64_t processed = 0;
+        size_t queued = 0;
+        size_t high_water = 0;       // Deepest input queue seen in the window
+        double avg_wait_ms = 0.0;    // Time jobs sat in the input queue
+        double avg_service_ms = 0.0; // Time spent on a job, including blocking on a full downstream queue
+        double max_service_ms = 0.0;
+    };
+
+    /**
+     * @brief One pipeline stage: a bounded input queue drained by its own pool of threads.
+     * The handler forwards results by pushing into the next stage, blocking while that stage is full.
+     */
+    template <typename Job> class PipelineStage
+    {
+    public:
+        using Handler = std::function<void(Job &)>;
+
+        PipelineStage(std::string name, size_t capacity) : m_name(std::move(name)), m_queue(capacity) {}
+        ~PipelineStage() { Stop(); }
+
+        void Start(size_t threads, Handler handler, std::function<void()> afterEach)
+        {
+            m_handler = std::move(handler);
+            m_afterEach = std::move(afterEach);
+            for (size_t i = 0; i < std::max<size_t>(1, threads); ++i)
+                m_threads.emplace_back(&PipelineStage::Run, this);
+        }
+
+        /// @brief Non-blocking push for work entering the pipeline. Leaves `job` untouched if full.
+        bool TryPush(Job &job)
+        {
+            Entry entry{std::move(job), std::chrono::steady_clock::now()};
+            if (!m_queue.try_push(entry))
+            {
+                job = std::move(entry.job);
+                return false;
+            }
+            NoteDepth();
+            return true;
+        }
+
+        /// @brief Blocking push used between stages. Returns false if the stage is shutting down.
+        bool Push(Job job)
+        {
+            if (!m_queue.push_wait(Entry{std::move(job), std::chrono::steady_clock::now()}))
+                return false;
+            NoteDepth();
+            return true;
+        }
+
+        /// @brief Closes the queue and joins the threads. Jobs still queued are dropped.
+        void Stop()
+        {
+            m_queue.close();
+            for (auto &t : m_threads)
+            {
+                if (t.joinable())
+                    t.join();
+            }
+            m_threads.clear();
+        }
+
+        /// @brief Snapshot of the current window; `reset` starts a new one.
+        StageStats Stats(bool reset)
+        {
+            StageStats stats;
+            stats.name = m_name;
+            stats.queued = m_queue.size();
+            stats.processed = reset ? m_processed.exchange(0) : m_processed.load();
+            uint64_t waitUs = reset ? m_waitUs.exchange(0) : m_waitUs.load();
+            uint64_t serviceUs = reset ? m_serviceUs.exchange(0) : m_serviceUs.load();
+            stats.max_service_ms = (reset ? m_maxServiceUs.exchange(0) : m_maxServiceUs.load()) / 1000.0;
+            stats.high_water = reset ? m_highWater.exchange(stats.queued) : m_highWater.load();
+            if (stats.processed > 0)
+            {
+                stats.avg_wait_ms = waitUs / 1000.0 / stats.processed;
+                stats.avg_service_ms = serviceUs / 1000.0 / stats.processed;
+            }
+            return stats;
+        }
+
+    private:
+        struct Entry
+        {
+            Job job;
+            std::chrono::steady_clock::time_point enqueued_at;
+        };
+
+        void Run()
+        {
+            Entry entry;
+            while (m_queue.wait_pop(entry))
+            {
+                auto started = std::chrono::steady_clock::now();
+                try
+                {
+                    m_handler(entry.job);
+                }
+                catch (const std::exception &e)
+                {
+                    std::cerr << "[Tracker] " << m_name << " stage error: " << e.what() << std::endl;
+                }
+                catch (...)
+                {
+                    std::cerr << "[Tracker] " << m_name << " stage unknown error" << std::endl;
+                }
+                auto finished = std::chrono::steady_clock::now();
+
+                using std::chrono::duration_cast;
+                using std::chrono::microseconds;
+                uint64_t waitUs = duration_cast<microseconds>(started - entry.enqueued_at).count();
+                uint64_t serviceUs = duration_cast<microseconds>(finished - started).count();
+
+                // Release the job (and the account it pins) right away rather than on the next pop
+                entry = Entry{};
+
+                m_processed.fetch_add(1);
+                m_waitUs.fetch_add(waitUs);
+                m_serviceUs.fetch_add(serviceUs);
+                uint64_t prevMax = m_maxServiceUs.load();
+                while (serviceUs > prevMax && !m_maxServiceUs.compare_exchange_weak(prevMax, serviceUs))
+                {
+                }
+
+                if (m_afterEach)
+                    m_afterEach();
+            }
+        }
+
+        void NoteDepth()
+        {
+            size_t depth = m_queue.size();
+            size_t prev = m_highWater.load();
+            while (depth > prev && !m_highWater.compare_exchange_weak(prev, depth))
+            {
+            }
+        }
+
+        std::string m_name;
+        Core::Utils::ThreadsafeQueue<Entry> m_queue;
+        Handler m_handler;
+        std::function<void()> m_afterEach;
+        std::vector<std::thread> m_threads;
+
+        std::atomic<uint64_t> m_processed{0};
+        std::atomic<uint64_t> m_waitUs{0};
+        std::atomic<uint64_t> m_serviceUs{0};
+        std::atomic<uint64_t> m_maxServiceUs{0};
+        std::atomic<size_t> m_highWater{0};
+    };
+
+    /**
+     * @brief Staged tracker engine (tracker_engine = "pipeline").
+     * Replaces the one-task-per-account checks with six stages, each with its own threads and bounded
+     * input queue: match-list fetch -> new-match filter -> match-detail fetch -> stat extraction ->
+     * persistence -> notification. Riot-bound stages overlap with DB- and Discord-bound ones, and a
+     * slow stage pushes back on the ones feeding it instead of growing memory without bound.
+     * Matches of one account may finish out of order; nothing downstream depends on order.
+     */
+    class TrackerPipeline
+    {
+    public:
+        TrackerPipeline(const TrackerPipelineOptions &options, std::shared_ptr<dpp::cluster> bot,
+                        std::shared_ptr<Server::DB::Database> db, std::shared_ptr<Server::Riot::RiotClient> riot,
+                        std::shared_ptr<PollSchedule> schedule = nullptr);
+        ~TrackerPipeline();
+
+        // Feeds one sweep into the pipeline; `accounts` holds the Discord links of each Riot account.
+        // Accounts still in the pipeline from an earlier sweep are skipped.
+        void Sweep(const std::vector<std::vector<Server::DB::User>> &accounts);
+
+        // Snapshot of the current window's per-stage statistics, in pipeline order.
+        std::vector<StageStats> GetStats();
+
+    private:
+        // Marks an account as in the pipeline. Shared by every job derived from the account's sweep
+        // entry; the last one to finish (or be dropped) advances the links' cursors if every match
+        // made it through, reports the poll to the schedule, and releases the account for the next sweep.
+        struct AccountRun
+        {
+            TrackerPipeline *pipeline;
+            std::string key;
+            std::vector<Server::DB::User> links;
+
+            std::mutex mutex;
+            PollProgress progress;
+            size_t outstanding = 0; // Matches handed to the detail stage and not yet persisted
+            bool polled = false;    // The match list came back from Riot
+            bool listed = false;    // The filter stage got through the whole match list
+
+            ~AccountRun() { pipeline->FinishAccount(*this); }
+        };
+
+        struct AccountJob
+        {
+            std::shared_ptr<AccountRun> run;
+            std::vector<Server::DB::User> links;
+        };
+
+        struct MatchListJob
+        {
+            std::shared_ptr<AccountRun> run;
+            std::vector<Server::DB::User> links;
+            std::vector<std::string> matches; // Oldest -> Newest
+        };
+
+        struct MatchJob
+        {
+            std::shared_ptr<AccountRun> run;
+            Server::DB::User account;              // Any link; supplies puuid/region/name
+            std::vector<Server::DB::User> pending; // Links that have not recorded this match yet
+            std::string match_id;
+        };
+
+        struct SummaryJob
+        {
+            MatchJob match;
+            std::shared_ptr<const Server::Riot::MatchSummary> summary;
+        };
+
+        struct StatsJob
+        {
+            MatchJob match;
+            Server::Riot::MatchStats stats;
+        };
+
+        struct NotifyJob
+        {
+            int64_t discord_id = 0;
+            std::string message;
+        };
+
+        void FetchMatchList(AccountJob &job);
+        void FilterNewMatches(MatchListJob &job);
+        void FetchMatchDetail(MatchJob &job);
+        void ExtractStats(SummaryJob &job);
+        void Persist(StatsJob &job);
+        void Notify(NotifyJob &job);
+
+        void FinishAccount(AccountRun &run);
+        void MaybeLogStats();
+
+        TrackerPipelineOptions m_options;
+        std::shared_ptr<dpp::cluster> m_bot;
+        std::shared_ptr<Server::DB::Database> m_db;
+        std::shared_ptr<Server::Riot::RiotClient> m_riot;
+        std::shared_ptr<PollSchedule> m_schedule; // Optional; told how each account's poll went
+
+        std::mutex m_inFlightMutex;
+        std::unordered_set<std::string> m_inFlight; // "puuid|region" of accounts in the pipeline
+
+        std::atomic<int64_t> m_nextStatsLog{0};
+
+        // Declared last: destroyed (threads joined) before the state above
+        PipelineStage<AccountJob> m_list;
+        PipelineStage<MatchListJob> m_filter;
+        PipelineStage<MatchJob> m_detail;
+        PipelineStage<SummaryJob> m_stats;
+        PipelineStage<StatsJob> m_persist;
+        PipelineStage<NotifyJob> m_notify;
+    };
+} // namespace Core::Tracker